@@ -0,0 +1,140 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixArena.cpp
+//
+// Description:
+//     Scratch buffers for building helices. See helixArena.h.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include "helixArena.h"
+
+static helixArena arena;
+
+helixArena& helixGetArena()
+{
+	return arena;
+}
+
+helixArena::helixArena()
+{
+	fPointCapacity = 0;
+	fKnotCapacity = 0;
+	fRequests = 0;
+	fReallocations = 0;
+}
+
+MPointArray& helixArena::points(unsigned count)
+	//
+	// Description
+	//     Shortening an MPointArray keeps its storage, so only a
+	//     length beyond the largest so far should reallocate. A move
+	//     of the storage is counted too, in case it does otherwise.
+	//
+{
+	fRequests++;
+	const MPoint* storage = fPoints.length() ? &fPoints[0] : NULL;
+	fPoints.setLength(count);
+	if (count > fPointCapacity || (count > 0 && &fPoints[0] != storage)) {
+		fReallocations++;
+		if (count > fPointCapacity)
+			fPointCapacity = count;
+	}
+	return fPoints;
+}
+
+const MDoubleArray& helixArena::knots(unsigned count)
+	//
+	// Description
+	//     Knot i is always i, so only the knots past the current
+	//     length need writing.
+	//
+{
+	fRequests++;
+	const double* storage = fKnots.length() ? &fKnots[0] : NULL;
+	unsigned filled = fKnots.length();
+	fKnots.setLength(count);
+	if (count > fKnotCapacity || (count > 0 && &fKnots[0] != storage)) {
+		fReallocations++;
+		if (count > fKnotCapacity)
+			fKnotCapacity = count;
+	}
+
+	for (unsigned i = filled; i < count; i++)
+		fKnots[i] = (double) i;
+	return fKnots;
+}
+
+float* helixArena::floats(size_t count)
+	//
+	// Description
+	//     A vector only allocates to raise its capacity, so a changed
+	//     capacity is exactly one trip to the heap.
+	//
+{
+	fRequests++;
+	if (count > fFloats.size()) {
+		const size_t capacity = fFloats.capacity();
+		fFloats.resize(count);
+		if (fFloats.capacity() != capacity)
+			fReallocations++;
+	}
+	return count ? &fFloats[0] : NULL;
+}
+
+double* helixArena::doubles(size_t count)
+{
+	fRequests++;
+	if (count > fDoubles.size()) {
+		const size_t capacity = fDoubles.capacity();
+		fDoubles.resize(count);
+		if (fDoubles.capacity() != capacity)
+			fReallocations++;
+	}
+	return count ? &fDoubles[0] : NULL;
+}
+
+void helixArena::beginBatch()
+{
+	fRequests = 0;
+	fReallocations = 0;
+}
+
+void helixArena::release()
+{
+	fPoints.clear();
+	fKnots.clear();
+	std::vector<float>().swap(fFloats);
+	std::vector<double>().swap(fDoubles);
+	fPointCapacity = 0;
+	fKnotCapacity = 0;
+}
+
+unsigned helixArena::requests() const
+{
+	return fRequests;
+}
+
+unsigned helixArena::reallocations() const
+{
+	return fReallocations;
+}
+
+size_t helixArena::reservedBytes() const
+{
+	return (size_t) fPointCapacity * sizeof(double) * 4 +
+		(size_t) fKnotCapacity * sizeof(double) +
+		fFloats.capacity() * sizeof(float) +
+		fDoubles.capacity() * sizeof(double);
+}
@@ -0,0 +1,87 @@
+#ifndef _helixArena
+#define _helixArena
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixArena.h
+//
+// Description:
+//     Scratch buffers for building helices, owned by the plugin.
+//
+//     Each helix needs CV, knot and (for springs) vertex buffers only
+//     until Maya has copied them into the new shape. The arena keeps
+//     one of each and hands the same storage back for every helix,
+//     growing it only when a helix is larger than any before, so a
+//     batch of similar helices touches the heap a handful of times in
+//     all rather than several times per helix.
+//
+//     Buffers are valid until the next request for the same kind of
+//     buffer. Call from the main thread only.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <maya/MPointArray.h>
+#include <maya/MDoubleArray.h>
+
+#include <vector>
+#include <stddef.h>
+
+class helixArena
+{
+public:
+					helixArena();
+
+	// A CV array of length count. Its contents are left over from
+	// earlier helices.
+	MPointArray&	points(unsigned count);
+
+	// The knots 0, 1, ... count-1, as used by every helix curve.
+	const MDoubleArray& knots(unsigned count);
+
+	// Raw storage for count values.
+	float*			floats(size_t count);
+	double*			doubles(size_t count);
+
+	// Starts a batch: zeroes the counters, keeps the storage.
+	void			beginBatch();
+
+	// Frees all storage.
+	void			release();
+
+	// Counters since beginBatch.
+	unsigned		requests() const;		// Buffers handed out
+	unsigned		reallocations() const;	// Of those, ones that reallocated
+	size_t			reservedBytes() const;	// Storage held now
+
+	// reallocations() counts the resizes that really went to the heap.
+	// For the vectors these are the ones that changed capacity(). Maya's
+	// arrays do not show their capacity, so for them a resize counts
+	// when it moved the storage or made the array longer than ever
+	// before, which can only overcount.
+
+private:
+	MPointArray		fPoints;
+	MDoubleArray	fKnots;
+	std::vector<float>	fFloats;
+	std::vector<double>	fDoubles;
+	unsigned		fPointCapacity;
+	unsigned		fKnotCapacity;
+	unsigned		fRequests;
+	unsigned		fReallocations;
+};
+
+// The plugin's arena.
+//
+helixArena&	helixGetArena();
+
+#endif
@@ -0,0 +1,316 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixBoundsTree.cpp
+//
+// Description:
+//     A bounding volume hierarchy over helices. See helixBoundsTree.h.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <float.h>
+
+#include <algorithm>
+
+#include "helixBoundsTree.h"
+
+// Most helices a leaf holds.
+static const unsigned kLeafSize = 4;
+
+/////////////////////////////////////////////////////////////
+// helixFrustum
+/////////////////////////////////////////////////////////////
+
+void helixFrustum::set(const double m[4][4])
+	//
+	// Description
+	//     With row vectors, clip coordinate j of a point is its dot
+	//     product with column j of the matrix, so each plane is a sum
+	//     or difference of the w column and another column. The near
+	//     plane is OpenGL's -w <= z, which also contains DirectX's
+	//     0 <= z, so the test is safe for both.
+	//
+{
+	for (unsigned axis = 0; axis < 3; axis++) {
+		for (unsigned k = 0; k < 4; k++) {
+			planes[2 * axis][k] = m[k][3] + m[k][axis];
+			planes[2 * axis + 1][k] = m[k][3] - m[k][axis];
+		}
+	}
+}
+
+bool helixFrustum::segmentInside(const float a[3], const float b[3]) const
+	//
+	// Description
+	//     Clips the segment's parameter range by each plane in turn
+	//     (Liang-Barsky); it is inside if any of the range is left.
+	//
+{
+	double t0 = 0.0, t1 = 1.0;
+	for (unsigned p = 0; p < 6; p++) {
+		const double* plane = planes[p];
+		double da = plane[0] * a[0] + plane[1] * a[1] + plane[2] * a[2] + plane[3];
+		double db = plane[0] * b[0] + plane[1] * b[1] + plane[2] * b[2] + plane[3];
+
+		if (da < 0.0 && db < 0.0)
+			return false;
+		if (da < 0.0)
+			t0 = std::max(t0, da / (da - db));
+		else if (db < 0.0)
+			t1 = std::min(t1, da / (da - db));
+		if (t0 > t1)
+			return false;
+	}
+	return true;
+}
+
+/////////////////////////////////////////////////////////////
+// helixBoundsTree
+/////////////////////////////////////////////////////////////
+
+static void cylinderBox(const helixCylinder& c, float* min, float* max)
+	//
+	// Description
+	//     The box around a cylinder: its caps are discs, whose extent
+	//     along axis k is r sqrt(1 - u_k^2) for the unit axis u.
+	//
+{
+	double axis[3];
+	double length2 = 0.0;
+	for (unsigned k = 0; k < 3; k++) {
+		axis[k] = c.top[k] - c.base[k];
+		length2 += axis[k] * axis[k];
+	}
+
+	for (unsigned k = 0; k < 3; k++) {
+		double across = (length2 > 0.0) ? 1.0 - axis[k] * axis[k] / length2 : 1.0;
+		double extent = c.radius * sqrt(across > 0.0 ? across : 0.0);
+		min[k] = (float) ((c.base[k] < c.top[k] ? c.base[k] : c.top[k]) - extent);
+		max[k] = (float) ((c.base[k] > c.top[k] ? c.base[k] : c.top[k]) + extent);
+	}
+}
+
+static bool cylinderOutside(const helixCylinder& c, const double plane[4])
+{
+	const double sBase = plane[0] * c.base[0] + plane[1] * c.base[1] +
+		plane[2] * c.base[2] + plane[3];
+	const double sTop = plane[0] * c.top[0] + plane[1] * c.top[1] +
+		plane[2] * c.top[2] + plane[3];
+
+	// Reach of the caps towards the plane normal.
+	double axis[3];
+	double length2 = 0.0, along = 0.0, normal2 = 0.0;
+	for (unsigned k = 0; k < 3; k++) {
+		axis[k] = c.top[k] - c.base[k];
+		length2 += axis[k] * axis[k];
+		along += axis[k] * plane[k];
+		normal2 += plane[k] * plane[k];
+	}
+	double across = (length2 > 0.0) ? normal2 - along * along / length2 : normal2;
+	double reach = c.radius * sqrt(across > 0.0 ? across : 0.0);
+
+	return (sBase > sTop ? sBase : sTop) + reach < 0.0;
+}
+
+// A helix while the tree is built. Items are partitioned in place so
+// that each subtree's items stay contiguous in memory.
+//
+struct helixBuildItem
+{
+	float			min[3];
+	float			max[3];
+	float			centre[3];
+	unsigned		index;
+};
+
+struct helixCentreLess
+{
+	unsigned		axis;
+
+	bool operator()(const helixBuildItem& a, const helixBuildItem& b) const
+	{
+		return a.centre[axis] < b.centre[axis];
+	}
+};
+
+helixBoundsTree::helixBoundsTree() {}
+
+void helixBoundsTree::clear()
+{
+	fNodes.clear();
+	fOrder.clear();
+	fCylinders.clear();
+}
+
+unsigned helixBoundsTree::size() const
+{
+	return (unsigned) fCylinders.size();
+}
+
+void helixBoundsTree::build(const std::vector<helixCylinder>& cylinders)
+{
+	clear();
+	fCylinders = cylinders;
+
+	const unsigned count = (unsigned) cylinders.size();
+	if (count == 0)
+		return;
+
+	std::vector<helixBuildItem> items(count);
+	for (unsigned i = 0; i < count; i++) {
+		helixBuildItem& item = items[i];
+		cylinderBox(cylinders[i], item.min, item.max);
+		for (unsigned k = 0; k < 3; k++)
+			item.centre[k] = 0.5f * (item.min[k] + item.max[k]);
+		item.index = i;
+	}
+
+	fNodes.reserve(2 * (count / kLeafSize + 1));
+	buildNode(&items[0], 0, count);
+
+	fOrder.resize(count);
+	for (unsigned i = 0; i < count; i++)
+		fOrder[i] = items[i].index;
+}
+
+unsigned helixBoundsTree::buildNode(helixBuildItem* items, unsigned first,
+	unsigned count)
+{
+	const unsigned index = (unsigned) fNodes.size();
+	fNodes.push_back(Node());
+
+	float min[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+	float max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	float centreMin[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+	float centreMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	for (unsigned i = first; i < first + count; i++) {
+		const helixBuildItem& item = items[i];
+		for (unsigned k = 0; k < 3; k++) {
+			min[k] = std::min(min[k], item.min[k]);
+			max[k] = std::max(max[k], item.max[k]);
+			centreMin[k] = std::min(centreMin[k], item.centre[k]);
+			centreMax[k] = std::max(centreMax[k], item.centre[k]);
+		}
+	}
+
+	Node& node = fNodes[index];
+	for (unsigned k = 0; k < 3; k++) {
+		node.min[k] = min[k];
+		node.max[k] = max[k];
+	}
+	node.first = first;
+	node.count = count;
+	node.right = 0;
+
+	if (count <= kLeafSize)
+		return index;
+
+	helixCentreLess less;
+	less.axis = 0;
+	for (unsigned k = 1; k < 3; k++) {
+		if (centreMax[k] - centreMin[k] > centreMax[less.axis] - centreMin[less.axis])
+			less.axis = k;
+	}
+
+	const unsigned half = count / 2;
+	std::nth_element(items + first, items + first + half, items + first + count, less);
+
+	buildNode(items, first, half);
+	unsigned right = buildNode(items, first + half, count - half);
+	fNodes[index].right = right;
+	return index;
+}
+
+void helixBoundsTree::cull(const helixFrustum& frustum,
+	std::vector<unsigned>& visible) const
+	//
+	// Description
+	//     Each node carries the planes its parent was not already
+	//     wholly inside, so the deeper the walk goes the fewer planes
+	//     each box is tested against. Leaves on the frustum boundary
+	//     test their helices' cylinders, which are much tighter than
+	//     the boxes for tilted helices.
+	//
+{
+	visible.clear();
+	if (fNodes.empty())
+		return;
+
+	struct Entry
+	{
+		unsigned	node;
+		unsigned	planes;
+	};
+
+	// Median splits keep the depth below 32 for any helix count.
+	Entry stack[64];
+	int depth = 0;
+	stack[depth].node = 0;
+	stack[depth].planes = 0x3f;
+	depth++;
+
+	while (depth > 0) {
+		const Entry entry = stack[--depth];
+		const Node& node = fNodes[entry.node];
+		unsigned planes = entry.planes;
+		bool outside = false;
+
+		for (unsigned p = 0; p < 6 && !outside; p++) {
+			if (!(planes & (1u << p)))
+				continue;
+
+			const double* plane = frustum.planes[p];
+			double distance = plane[3];
+			double reach = 0.0;
+			for (unsigned k = 0; k < 3; k++) {
+				distance += plane[k] * 0.5 * ((double) node.min[k] + node.max[k]);
+				reach += fabs(plane[k]) * 0.5 * ((double) node.max[k] - node.min[k]);
+			}
+
+			if (distance + reach < 0.0)
+				outside = true;
+			else if (distance - reach >= 0.0)
+				planes &= ~(1u << p);
+		}
+
+		if (outside)
+			continue;
+
+		if (planes == 0) {
+			visible.insert(visible.end(), fOrder.begin() + node.first,
+				fOrder.begin() + node.first + node.count);
+		}
+		else if (node.right == 0) {
+			for (unsigned i = node.first; i < node.first + node.count; i++) {
+				const helixCylinder& cylinder = fCylinders[fOrder[i]];
+				bool culled = false;
+				for (unsigned p = 0; p < 6 && !culled; p++) {
+					if (planes & (1u << p))
+						culled = cylinderOutside(cylinder, frustum.planes[p]);
+				}
+				if (!culled)
+					visible.push_back(fOrder[i]);
+			}
+		}
+		else {
+			stack[depth].node = node.right;
+			stack[depth].planes = planes;
+			depth++;
+			stack[depth].node = entry.node + 1;
+			stack[depth].planes = planes;
+			depth++;
+		}
+	}
+}
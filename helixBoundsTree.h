@@ -0,0 +1,92 @@
+#ifndef _helixBoundsTree
+#define _helixBoundsTree
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixBoundsTree.h
+//
+// Description:
+//     A bounding volume hierarchy over helices, for view culling.
+//
+//     Every helix lies inside a cylinder known from its parameters
+//     alone: radius r around its axis, from its base to the height of
+//     its last CV. The tree holds those cylinders in axis aligned
+//     boxes, split at the median of the longest axis down to a few
+//     helices per leaf. Nodes are stored depth first with the
+//     helices of a subtree contiguous, so a subtree that is wholly
+//     visible is accepted without visiting it.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+// Bounding cylinder of one helix.
+//
+struct helixCylinder
+{
+	float			base[3];		// Centre of the bottom cap
+	float			top[3];			// Centre of the top cap
+	float			radius;
+};
+
+// The six clip planes of a view, as a x + b y + c z + d >= 0 inside.
+//
+class helixFrustum
+{
+public:
+	// Planes of the clip volume of toClip, a matrix taking points to
+	// clip space as row vectors (as MMatrix does).
+	void			set(const double toClip[4][4]);
+
+	// True if any part of the segment from a to b is inside.
+	bool			segmentInside(const float a[3], const float b[3]) const;
+
+	double			planes[6][4];
+};
+
+struct helixBuildItem;
+
+class helixBoundsTree
+{
+public:
+					helixBoundsTree();
+
+	void			build(const std::vector<helixCylinder>& cylinders);
+	void			clear();
+	unsigned		size() const;
+
+	// Sets visible to the indices of every helix whose cylinder is
+	// not wholly outside the frustum, in tree order.
+	void			cull(const helixFrustum& frustum,
+						std::vector<unsigned>& visible) const;
+
+private:
+	struct Node
+	{
+		float		min[3];
+		float		max[3];
+		unsigned	first;			// First entry of fOrder in the subtree
+		unsigned	count;			// Helices in the subtree
+		unsigned	right;			// Right child; 0 for a leaf. The
+									// left child is the next node.
+	};
+
+	unsigned		buildNode(helixBuildItem* items,
+						unsigned first, unsigned count);
+
+	std::vector<Node>			fNodes;
+	std::vector<unsigned>		fOrder;		// Helix indices, grouped by leaf
+	std::vector<helixCylinder>	fCylinders;
+};
+
+#endif
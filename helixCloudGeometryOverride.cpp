@@ -0,0 +1,360 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixCloudGeometryOverride.cpp
+//
+// Description:
+//     Viewport 2.0 drawing for the helixCloud shape.
+//     See helixCloudGeometryOverride.h.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+
+#include <maya/MFnDependencyNode.h>
+#include <maya/MMatrix.h>
+#include <maya/MColor.h>
+#include <maya/M3dView.h>
+#include <maya/MShaderManager.h>
+#include <maya/MHWGeometryUtilities.h>
+#include <maya/MViewport2Renderer.h>
+
+#include "helixCloudGeometryOverride.h"
+#include "helixCloudShape.h"
+#include "helixGeometry.h"
+
+const MString helixCloudGeometryOverride::registrantId( "helixCloudGeometryOverride" );
+const MString helixCloudGeometryOverride::drawDbClassification( "drawdb/geometry/helixCloud" );
+
+static const MString kWireItemName( "helixCloudWire" );
+
+// Level used when there is no view to measure helices against.
+static const unsigned char kDefaultLod = 4;
+
+// Level of a helix outside the view, which is not drawn.
+static const unsigned char kCulledLod = 0xff;
+
+// Upper bound on the points drawn for one cloud. Levels are halved
+// for every helix until the cloud fits.
+static const unsigned kMaxCloudVertices = 16 * 1024 * 1024;
+
+static unsigned polylineSamples(unsigned numCVs, unsigned char lod)
+{
+	return (lod == kCulledLod) ? 0 : helixPolylineSamples(numCVs, lod);
+}
+
+MHWRender::MPxGeometryOverride* helixCloudGeometryOverride::Creator(const MObject& obj)
+{
+	return new helixCloudGeometryOverride(obj);
+}
+
+helixCloudGeometryOverride::helixCloudGeometryOverride(const MObject& obj)
+	: MHWRender::MPxGeometryOverride(obj)
+	, fShape(NULL)
+	, fData(NULL)
+	, fDataRevision(0)
+	, fHasData(false)
+	, fBuilt(false)
+	, fBuiltRevision(0)
+{
+	MFnDependencyNode node(obj);
+	fShape = (helixCloudShape*) node.userNode();
+}
+
+helixCloudGeometryOverride::~helixCloudGeometryOverride() {}
+
+MHWRender::DrawAPI helixCloudGeometryOverride::supportedDrawAPIs() const
+{
+	return MHWRender::kAllDevices;
+}
+
+void helixCloudGeometryOverride::getViews(std::vector<helixLodView>& views)
+	//
+	// Description
+	//     Every visible 3d view, whose cameras decide the levels.
+	//
+{
+	views.clear();
+	const unsigned count = M3dView::numberOf3dViews();
+	for (unsigned v = 0; v < count; v++) {
+		M3dView view;
+		if (!M3dView::get3dView(v, view) || !view.isVisible())
+			continue;
+
+		helixLodView lodView;
+		view.modelViewMatrix(lodView.viewMatrix);
+		view.projectionMatrix(lodView.projection);
+		lodView.portHeight = view.portHeight();
+		views.push_back(lodView);
+	}
+}
+
+bool helixCloudGeometryOverride::viewsMoved(const std::vector<helixLodView>& views) const
+{
+	if (views.size() != fBuiltViews.size() || fPath.inclusiveMatrix() != fBuiltMatrix)
+		return true;
+	for (size_t v = 0; v < views.size(); v++) {
+		if (views[v].viewMatrix != fBuiltViews[v].viewMatrix ||
+			views[v].projection != fBuiltViews[v].projection ||
+			views[v].portHeight != fBuiltViews[v].portHeight)
+			return true;
+	}
+	return false;
+}
+
+void helixCloudGeometryOverride::computeLod(const std::vector<helixLodView>& views,
+	std::vector<unsigned char>& lod) const
+	//
+	// Description
+	//     Culls the helices against each view with the cloud's bounds
+	//     tree, then picks segments per radian for each one left from
+	//     the radius it covers on screen, keeping the finest over the
+	//     views. The depth used is the clip w of the helix centre, so
+	//     the same sum serves for perspective and orthographic
+	//     cameras.
+	//
+{
+	const unsigned count = fData ? fData->count() : 0;
+	lod.assign(count, kDefaultLod);
+	if (count == 0 || views.empty())
+		return;
+
+	lod.assign(count, kCulledLod);
+	const MMatrix placement = fPath.inclusiveMatrix();
+
+	for (size_t v = 0; v < views.size(); v++) {
+		const MMatrix& projection = views[v].projection;
+		const MMatrix toView = placement * views[v].viewMatrix;
+		const double scale = sqrt(toView[0][0] * toView[0][0] +
+			toView[0][1] * toView[0][1] + toView[0][2] * toView[0][2]);
+		const double pixels = scale * projection[1][1] * 0.5 * (double) views[v].portHeight;
+
+		helixFrustum frustum;
+		frustum.set((toView * projection).matrix);
+		fData->boundsTree().cull(frustum, fVisible);
+
+		for (size_t k = 0; k < fVisible.size(); k++) {
+			const unsigned i = fVisible[k];
+
+			// Helix centre: position plus half its height along the
+			// rotated Y axis.
+			const double x = fData->qx[i], y = fData->qy[i];
+			const double z = fData->qz[i], w = fData->qw[i];
+			const double rise = (fData->flags[i] & helixCloudData::kUpsideDown) ?
+				-fData->pitch[i] : fData->pitch[i];
+			const double half = 0.5 * rise * (double) (fData->numCVs[i] - 1);
+
+			const double cx = fData->px[i] + half * 2.0 * (x * y - w * z);
+			const double cy = fData->py[i] + half * (1.0 - 2.0 * (x * x + z * z));
+			const double cz = fData->pz[i] + half * 2.0 * (y * z + w * x);
+
+			const double viewZ = cx * toView[0][2] + cy * toView[1][2] +
+				cz * toView[2][2] + toView[3][2];
+			const double clipW = viewZ * projection[2][3] + projection[3][3];
+
+			const unsigned char level = (clipW > 0.0) ? (unsigned char) helixLodSegmentsPerRadian(
+				helixCurveRadius(fData->radius[i]) * pixels / clipW) : 0;
+			if (lod[i] == kCulledLod || level > lod[i])
+				lod[i] = level;
+		}
+	}
+
+	// Keep within the vertex budget.
+	for (;;) {
+		size_t total = 0;
+		for (unsigned i = 0; i < count; i++)
+			total += polylineSamples(fData->numCVs[i], lod[i]);
+		if (total <= kMaxCloudVertices)
+			break;
+
+		bool reduced = false;
+		for (unsigned i = 0; i < count; i++) {
+			if (lod[i] > 0 && lod[i] != kCulledLod) {
+				lod[i] /= 2;
+				reduced = true;
+			}
+		}
+		if (!reduced)
+			break;
+	}
+}
+
+bool helixCloudGeometryOverride::requiresGeometryUpdate() const
+	//
+	// Description
+	//     The buffers are kept from frame to frame until the helices
+	//     change or moving a camera changes a level of detail. The
+	//     levels are only worked out again when something they depend
+	//     on has moved.
+	//
+{
+	if (!fBuilt || fShape == NULL || fShape->revision() != fBuiltRevision)
+		return true;
+
+	getViews(fViews);
+	if (!viewsMoved(fViews))
+		return false;
+
+	computeLod(fViews, fLod);
+	if (fLod != fBuiltLod)
+		return true;
+
+	// Same levels from here, so remember the views to skip the work
+	// next time.
+	fBuiltViews.swap(fViews);
+	fBuiltMatrix = fPath.inclusiveMatrix();
+	return false;
+}
+
+void helixCloudGeometryOverride::updateDG()
+	//
+	// Description
+	//     Fetches the helices from the shape without copying them.
+	//     Every change to them, or to the data object holding them,
+	//     bumps the shape's revision, so the view is good for as long
+	//     as the revision stays at fDataRevision; the other methods
+	//     check that before reading through it.
+	//
+{
+	if (fShape == NULL)
+		return;
+
+	fData = fShape->cloudData();
+	fDataRevision = fShape->revision();
+	fHasData = true;
+}
+
+void helixCloudGeometryOverride::updateRenderItems(const MDagPath& path,
+	MHWRender::MRenderItemList& list)
+{
+	fPath = path;
+
+	MHWRender::MRenderItem* wire = NULL;
+	int index = list.indexOf(kWireItemName);
+	if (index < 0) {
+		wire = MHWRender::MRenderItem::Create(kWireItemName,
+			MHWRender::MRenderItem::NonMaterialSceneItem,
+			MHWRender::MGeometry::kLines);
+		wire->setDrawMode(MHWRender::MGeometry::kAll);
+		wire->depthPriority(MHWRender::MRenderItem::sDormantWireDepthPriority);
+		list.append(wire);
+	}
+	else {
+		wire = list.itemAt(index);
+	}
+
+	MHWRender::MRenderer* renderer = MHWRender::MRenderer::theRenderer();
+	const MHWRender::MShaderManager* shaderMgr = renderer ? renderer->getShaderManager() : NULL;
+	if (shaderMgr == NULL)
+		return;
+
+	MHWRender::MShaderInstance* shader =
+		shaderMgr->getStockShader(MHWRender::MShaderManager::k3dSolidShader);
+	if (shader) {
+		MColor color = MHWRender::MGeometryUtilities::wireframeColor(path);
+		float solidColor[] = { color.r, color.g, color.b, 1.0f };
+		shader->setParameter("solidColor", solidColor);
+		wire->setShader(shader);
+		shaderMgr->releaseShader(shader);
+	}
+}
+
+void helixCloudGeometryOverride::populateGeometry(
+	const MHWRender::MGeometryRequirements& requirements,
+	const MHWRender::MRenderItemList& renderItems,
+	MHWRender::MGeometry& data)
+	//
+	// Description
+	//     Writes one polyline per helix into a single position buffer,
+	//     and line-list indices joining consecutive points of each.
+	//
+{
+	fBuilt = false;
+	if (!fHasData || fShape == NULL || fShape->revision() != fDataRevision)
+		return;
+
+	getViews(fBuiltViews);
+	fBuiltMatrix = fPath.inclusiveMatrix();
+	computeLod(fBuiltViews, fBuiltLod);
+
+	const unsigned count = fData ? fData->count() : 0;
+	unsigned numVertices = 0;
+	unsigned numIndices = 0;
+	for (unsigned i = 0; i < count; i++) {
+		unsigned samples = polylineSamples(fData->numCVs[i], fBuiltLod[i]);
+		numVertices += samples;
+		if (samples > 1)
+			numIndices += 2 * (samples - 1);
+	}
+
+	const MHWRender::MVertexBufferDescriptorList& descList =
+		requirements.vertexRequirements();
+	for (int d = 0; d < descList.length(); d++) {
+		MHWRender::MVertexBufferDescriptor desc;
+		if (!descList.getDescriptor(d, desc) ||
+			desc.semantic() != MHWRender::MGeometry::kPosition)
+			continue;
+
+		MHWRender::MVertexBuffer* positions = data.createVertexBuffer(desc);
+		float* xyz = positions ? (float*) positions->acquire(numVertices, true) : NULL;
+		if (xyz == NULL)
+			continue;
+
+		float* next = xyz;
+		for (unsigned i = 0; i < count; i++) {
+			unsigned samples = polylineSamples(fData->numCVs[i], fBuiltLod[i]);
+			if (samples == 0)
+				continue;
+			double rise = (fData->flags[i] & helixCloudData::kUpsideDown) ?
+				-fData->pitch[i] : fData->pitch[i];
+			MMatrix m = fData->matrix(i);
+
+			helixPolyline(fData->radius[i], rise, fData->numCVs[i], samples, m.matrix, next);
+			next += 3 * samples;
+		}
+		positions->commit(xyz);
+	}
+
+	for (int r = 0; r < renderItems.length(); r++) {
+		const MHWRender::MRenderItem* item = renderItems.itemAt(r);
+		if (item == NULL || item->name() != kWireItemName)
+			continue;
+
+		MHWRender::MIndexBuffer* indexBuffer =
+			data.createIndexBuffer(MHWRender::MGeometry::kUnsignedInt32);
+		unsigned* indices = indexBuffer ?
+			(unsigned*) indexBuffer->acquire(numIndices, true) : NULL;
+		if (indices == NULL)
+			continue;
+
+		unsigned first = 0;
+		unsigned* out = indices;
+		for (unsigned i = 0; i < count; i++) {
+			unsigned samples = polylineSamples(fData->numCVs[i], fBuiltLod[i]);
+			for (unsigned k = 0; k + 1 < samples; k++) {
+				*out++ = first + k;
+				*out++ = first + k + 1;
+			}
+			first += samples;
+		}
+		indexBuffer->commit(indices);
+		item->associateWithIndexBuffer(indexBuffer);
+	}
+
+	fBuiltRevision = fDataRevision;
+	fBuilt = true;
+}
+
+void helixCloudGeometryOverride::cleanUp()
+{
+}
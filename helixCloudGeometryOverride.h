@@ -0,0 +1,100 @@
+#ifndef _helixCloudGeometryOverride
+#define _helixCloudGeometryOverride
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixCloudGeometryOverride.h
+//
+// Description:
+//     Viewport 2.0 drawing for the helixCloud shape.
+//
+//     Every helix is drawn as a polyline written straight into the
+//     vertex buffer from its parameters with helixPolyline(). The
+//     number of points per helix follows its size on screen, helices
+//     outside the view are culled with the cloud's helixBoundsTree,
+//     and the buffers are rebuilt only when the helices or the chosen
+//     levels of detail change.
+//
+//     A geometry override's buffers are shared by every viewport
+//     drawing the shape, so the level of each helix is the finest any
+//     visible 3d view needs, and a helix is culled only when it is
+//     outside all of them. Levels are recomputed only when a view's
+//     camera or size, or the shape's placement, has moved.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <maya/MPxGeometryOverride.h>
+#include <maya/MHWGeometry.h>
+#include <maya/MDagPath.h>
+#include <maya/MMatrix.h>
+#include <maya/MString.h>
+
+#include <vector>
+
+#include "helixCloudShape.h"
+
+// What the levels of detail were chosen from, for one 3d view.
+//
+struct helixLodView
+{
+	MMatrix			viewMatrix;
+	MMatrix			projection;
+	int				portHeight;
+};
+
+class helixCloudGeometryOverride : public MHWRender::MPxGeometryOverride
+{
+public:
+	static MHWRender::MPxGeometryOverride* Creator(const MObject& obj);
+
+	virtual			~helixCloudGeometryOverride();
+
+	virtual MHWRender::DrawAPI supportedDrawAPIs() const;
+	virtual bool	requiresGeometryUpdate() const;
+
+	virtual void	updateDG();
+	virtual void	updateRenderItems(const MDagPath& path,
+						MHWRender::MRenderItemList& list);
+	virtual void	populateGeometry(const MHWRender::MGeometryRequirements& requirements,
+						const MHWRender::MRenderItemList& renderItems,
+						MHWRender::MGeometry& data);
+	virtual void	cleanUp();
+
+	static const MString	registrantId;
+	static const MString	drawDbClassification;
+
+private:
+					helixCloudGeometryOverride(const MObject& obj);
+
+	static void		getViews(std::vector<helixLodView>& views);
+	bool			viewsMoved(const std::vector<helixLodView>& views) const;
+	void			computeLod(const std::vector<helixLodView>& views,
+						std::vector<unsigned char>& lod) const;
+
+	helixCloudShape*		fShape;
+	const helixCloudData*	fData;			// The shape's helices, fetched
+											// by updateDG; NULL for none
+	unsigned				fDataRevision;	// Shape revision of fData
+	bool					fHasData;		// fData has been fetched
+	MDagPath				fPath;			// Set by updateRenderItems
+	bool					fBuilt;			// The buffers hold fBuiltLod
+	unsigned				fBuiltRevision;	// Shape revision of the buffers
+	std::vector<unsigned char> fBuiltLod;	// Segments per radian per helix
+	mutable std::vector<helixLodView> fBuiltViews;	// Views fBuiltLod suits
+	mutable MMatrix			fBuiltMatrix;	// And the shape's placement
+	mutable std::vector<helixLodView> fViews;	// Scratch for requiresGeometryUpdate
+	mutable std::vector<unsigned char> fLod;	// Scratch for requiresGeometryUpdate
+	mutable std::vector<unsigned> fVisible;	// Scratch for computeLod
+};
+
+#endif
@@ -0,0 +1,662 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixCloudShape.cpp
+//
+// Description:
+//     A surface shape holding any number of helices in one DAG node.
+//     See helixCloudShape.h.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <float.h>
+
+#include <maya/MFnTypedAttribute.h>
+#include <maya/MFnPluginData.h>
+#include <maya/MDataBlock.h>
+#include <maya/MDataHandle.h>
+#include <maya/MPlug.h>
+#include <maya/MPlugArray.h>
+#include <maya/MQuaternion.h>
+#include <maya/MTransformationMatrix.h>
+#include <maya/MPoint.h>
+#include <maya/MVector.h>
+#include <maya/MViewport2Renderer.h>
+#include <maya/MSelectionMask.h>
+#include <maya/MDagPath.h>
+#include <maya/M3dView.h>
+
+#include <vector>
+
+#include "helixCloudShape.h"
+#include "helixGeometry.h"
+
+// Version of the helixCloudData binary layout.
+#define kHelixCloudDataVersion	1
+
+// How close, in pixels, a click must come to a helix to pick it.
+#define kPickPixels				4.0
+
+// Points per radian tested against a selection marquee.
+#define kMarqueeSegments		8
+
+/////////////////////////////////////////////////////////////
+// helixCloudData
+/////////////////////////////////////////////////////////////
+
+const MTypeId helixCloudData::id( kHelixCloudDataId );
+const MString helixCloudData::typeName( "helixCloudData" );
+
+helixCloudData::helixCloudData()
+	: fBoundsDirty(true)
+	, fTreeDirty(true)
+{
+}
+
+helixCloudData::~helixCloudData() {}
+
+void* helixCloudData::creator()
+{
+	return new helixCloudData;
+}
+
+MTypeId helixCloudData::typeId() const
+{
+	return id;
+}
+
+MString helixCloudData::name() const
+{
+	return typeName;
+}
+
+unsigned helixCloudData::bytesPerHelix()
+{
+	return 9 * sizeof(float) + sizeof(unsigned) + sizeof(unsigned char);
+}
+
+unsigned helixCloudData::count() const
+{
+	return (unsigned) radius.size();
+}
+
+void helixCloudData::reserve(unsigned count)
+{
+	px.reserve(count); py.reserve(count); pz.reserve(count);
+	qx.reserve(count); qy.reserve(count); qz.reserve(count); qw.reserve(count);
+	radius.reserve(count);
+	pitch.reserve(count);
+	numCVs.reserve(count);
+	flags.reserve(count);
+}
+
+void helixCloudData::resize(unsigned count)
+{
+	px.resize(count, 0.0f); py.resize(count, 0.0f); pz.resize(count, 0.0f);
+	qx.resize(count, 0.0f); qy.resize(count, 0.0f); qz.resize(count, 0.0f);
+	qw.resize(count, 1.0f);
+	radius.resize(count, 1.0f);
+	pitch.resize(count, 0.0f);
+	numCVs.resize(count, 4);
+	flags.resize(count, 0);
+	fBoundsDirty = true;
+	fTreeDirty = true;
+}
+
+void helixCloudData::copy(const MPxData& src)
+{
+	const helixCloudData& other = (const helixCloudData&) src;
+
+	px = other.px; py = other.py; pz = other.pz;
+	qx = other.qx; qy = other.qy; qz = other.qz; qw = other.qw;
+	radius = other.radius;
+	pitch = other.pitch;
+	numCVs = other.numCVs;
+	flags = other.flags;
+	fBoundsDirty = true;
+	fTreeDirty = true;
+}
+
+void helixCloudData::append(double helixRadius, double helixPitch,
+	unsigned numCV, bool upsideDown, const MMatrix& placement)
+{
+	MTransformationMatrix xform(placement);
+	MQuaternion q = xform.rotation();
+	MVector t = xform.getTranslation(MSpace::kTransform);
+
+	px.push_back((float) t.x);
+	py.push_back((float) t.y);
+	pz.push_back((float) t.z);
+	qx.push_back((float) q.x);
+	qy.push_back((float) q.y);
+	qz.push_back((float) q.z);
+	qw.push_back((float) q.w);
+	radius.push_back((float) helixRadius);
+	pitch.push_back((float) helixPitch);
+	numCVs.push_back(numCV);
+	flags.push_back(upsideDown ? kUpsideDown : 0);
+	fBoundsDirty = true;
+	fTreeDirty = true;
+}
+
+MMatrix helixCloudData::matrix(unsigned index) const
+{
+	MMatrix m = MQuaternion(qx[index], qy[index], qz[index], qw[index]).asMatrix();
+	m[3][0] = px[index];
+	m[3][1] = py[index];
+	m[3][2] = pz[index];
+	return m;
+}
+
+void helixCloudData::getCVs(unsigned index, MPointArray& cvs) const
+	//
+	// Description
+	//     The CVs helixTool would build for this helix, placed by its
+	//     position and orientation.
+	//
+{
+	const unsigned ncvs = numCVs[index];
+	const double r = radius[index];
+	const double h = (flags[index] & kUpsideDown) ? -pitch[index] : pitch[index];
+	const MMatrix m = matrix(index);
+
+	cvs.setLength(ncvs);
+	for (unsigned i = 0; i < ncvs; i++)
+		cvs[i] = MPoint(r * cos((double) i), h * (double) i, r * sin((double) i)) * m;
+}
+
+void helixCloudData::helixBounds(unsigned index, float min[3], float max[3]) const
+	//
+	// Description
+	//     Box around the bounding cylinder of one helix: radius r about
+	//     the local Y axis, from 0 to the height of the last CV.
+	//
+{
+	const double r = radius[index];
+	const double h = (flags[index] & kUpsideDown) ? -pitch[index] : pitch[index];
+	const double top = h * (double) (numCVs[index] - 1);
+	const double half[3] = { r, 0.5 * fabs(top), r };
+	const MMatrix m = matrix(index);
+
+	// Centre of the cylinder, then its half extents along world axes.
+	MPoint centre = MPoint(0.0, 0.5 * top, 0.0) * m;
+	for (unsigned axis = 0; axis < 3; axis++) {
+		double extent = fabs(m[0][axis]) * half[0] +
+			fabs(m[1][axis]) * half[1] + fabs(m[2][axis]) * half[2];
+		min[axis] = (float) (centre[axis] - extent);
+		max[axis] = (float) (centre[axis] + extent);
+	}
+}
+
+MBoundingBox helixCloudData::bounds() const
+{
+	if (fBoundsDirty) {
+		fBounds.clear();
+		for (unsigned i = 0; i < count(); i++) {
+			float min[3], max[3];
+			helixBounds(i, min, max);
+			fBounds.expand(MPoint(min[0], min[1], min[2]));
+			fBounds.expand(MPoint(max[0], max[1], max[2]));
+		}
+		fBoundsDirty = false;
+	}
+	return fBounds;
+}
+
+void helixCloudData::getCylinder(unsigned index, helixCylinder& cylinder) const
+	//
+	// Description
+	//     The CVs, and so the curve, lie within the CV radius of the
+	//     helix axis, between its base and the height of the last CV.
+	//
+{
+	const double x = qx[index], y = qy[index], z = qz[index], w = qw[index];
+	const double h = (flags[index] & kUpsideDown) ? -pitch[index] : pitch[index];
+	const double top = h * (double) (numCVs[index] - 1);
+
+	// The local Y axis, rotated.
+	const double axis[3] = {
+		2.0 * (x * y - w * z),
+		1.0 - 2.0 * (x * x + z * z),
+		2.0 * (y * z + w * x)
+	};
+	const float position[3] = { px[index], py[index], pz[index] };
+
+	for (unsigned k = 0; k < 3; k++) {
+		cylinder.base[k] = position[k];
+		cylinder.top[k] = (float) (position[k] + top * axis[k]);
+	}
+	cylinder.radius = radius[index];
+}
+
+const helixBoundsTree& helixCloudData::boundsTree() const
+{
+	if (fTreeDirty) {
+		std::vector<helixCylinder> cylinders(count());
+		for (unsigned i = 0; i < count(); i++)
+			getCylinder(i, cylinders[i]);
+		fTree.build(cylinders);
+		fTreeDirty = false;
+	}
+	return fTree;
+}
+
+static bool isFinite(double value)
+{
+	return value == value && fabs(value) <= DBL_MAX;
+}
+
+bool helixCloudData::validHelices() const
+	//
+	// Description
+	//     Checks helices read from a file by the rules helixToolCmd
+	//     applies to new ones, so that corrupt values cannot reach
+	//     code that counts on them, such as numCVs - 1 for the height
+	//     of the last CV.
+	//
+{
+	for (unsigned i = 0; i < count(); i++) {
+		if (numCVs[i] < 4 ||
+			!isFinite(radius[i]) || radius[i] <= 0.0f ||
+			!isFinite(pitch[i]) || pitch[i] < 0.0f ||
+			!isFinite(px[i]) || !isFinite(py[i]) || !isFinite(pz[i]) ||
+			!isFinite(qx[i]) || !isFinite(qy[i]) || !isFinite(qz[i]) ||
+			!isFinite(qw[i]))
+			return false;
+	}
+	return true;
+}
+
+// ASCII form: the helix count, then for each helix
+// px py pz qx qy qz qw radius pitch numCVs flags.
+//
+MStatus helixCloudData::readASCII(const MArgList& args, unsigned& lastElement)
+{
+	MStatus stat;
+
+	// Compared by division, so a corrupt count cannot wrap around.
+	const int given = args.asInt(lastElement++, &stat);
+	if (!stat || given < 0 || args.length() < lastElement ||
+		(args.length() - lastElement) / 11 < (unsigned) given)
+		return MS::kFailure;
+	const unsigned n = (unsigned) given;
+
+	resize(n);
+	for (unsigned i = 0; i < n; i++) {
+		px[i] = (float) args.asDouble(lastElement++);
+		py[i] = (float) args.asDouble(lastElement++);
+		pz[i] = (float) args.asDouble(lastElement++);
+		qx[i] = (float) args.asDouble(lastElement++);
+		qy[i] = (float) args.asDouble(lastElement++);
+		qz[i] = (float) args.asDouble(lastElement++);
+		qw[i] = (float) args.asDouble(lastElement++);
+		radius[i] = (float) args.asDouble(lastElement++);
+		pitch[i] = (float) args.asDouble(lastElement++);
+		numCVs[i] = (unsigned) args.asInt(lastElement++);
+		flags[i] = (unsigned char) args.asInt(lastElement++);
+	}
+
+	if (!validHelices()) {
+		resize(0);
+		return MS::kFailure;
+	}
+	return MS::kSuccess;
+}
+
+MStatus helixCloudData::writeASCII(ostream& out)
+{
+	std::streamsize oldPrecision = out.precision(9);
+
+	out << count();
+	for (unsigned i = 0; i < count(); i++) {
+		out << "\n" << px[i] << " " << py[i] << " " << pz[i]
+			<< " " << qx[i] << " " << qy[i] << " " << qz[i] << " " << qw[i]
+			<< " " << radius[i] << " " << pitch[i]
+			<< " " << numCVs[i] << " " << (unsigned) flags[i];
+	}
+	out << " ";
+
+	out.precision(oldPrecision);
+	return out.fail() ? MS::kFailure : MS::kSuccess;
+}
+
+template <class T>
+static void writeArray(ostream& out, const std::vector<T>& values)
+{
+	if (!values.empty())
+		out.write((const char*) &values[0], values.size() * sizeof(T));
+}
+
+template <class T>
+static void readArray(istream& in, std::vector<T>& values)
+{
+	if (!values.empty())
+		in.read((char*) &values[0], values.size() * sizeof(T));
+}
+
+// Binary form: version and helix count as unsigned ints, then each
+// array of the structure-of-arrays in turn.
+//
+MStatus helixCloudData::writeBinary(ostream& out)
+{
+	unsigned header[2] = { kHelixCloudDataVersion, count() };
+	out.write((const char*) header, sizeof(header));
+
+	writeArray(out, px); writeArray(out, py); writeArray(out, pz);
+	writeArray(out, qx); writeArray(out, qy); writeArray(out, qz); writeArray(out, qw);
+	writeArray(out, radius);
+	writeArray(out, pitch);
+	writeArray(out, numCVs);
+	writeArray(out, flags);
+
+	return out.fail() ? MS::kFailure : MS::kSuccess;
+}
+
+MStatus helixCloudData::readBinary(istream& in, unsigned length)
+{
+	unsigned header[2];
+	in.read((char*) header, sizeof(header));
+	if (in.fail() || header[0] != kHelixCloudDataVersion)
+		return MS::kFailure;
+
+	// Compared by division, so a corrupt count cannot wrap around.
+	if (length < sizeof(header) ||
+		(length - sizeof(header)) / bytesPerHelix() < header[1])
+		return MS::kFailure;
+
+	resize(header[1]);
+	readArray(in, px); readArray(in, py); readArray(in, pz);
+	readArray(in, qx); readArray(in, qy); readArray(in, qz); readArray(in, qw);
+	readArray(in, radius);
+	readArray(in, pitch);
+	readArray(in, numCVs);
+	readArray(in, flags);
+
+	if (in.fail() || !validHelices()) {
+		resize(0);
+		return MS::kFailure;
+	}
+	return MS::kSuccess;
+}
+
+/////////////////////////////////////////////////////////////
+// helixCloudShape
+/////////////////////////////////////////////////////////////
+
+const MTypeId helixCloudShape::id( kHelixCloudShapeId );
+const MString helixCloudShape::typeName( "helixCloud" );
+
+MObject helixCloudShape::helixData;
+
+helixCloudShape::helixCloudShape()
+	: fRevision(0)
+{
+}
+helixCloudShape::~helixCloudShape() {}
+
+void* helixCloudShape::creator()
+{
+	return new helixCloudShape;
+}
+
+MStatus helixCloudShape::initialize()
+{
+	MStatus stat;
+	MFnTypedAttribute typedAttr;
+
+	helixData = typedAttr.create("helixData", "hd", helixCloudData::id,
+		MObject::kNullObj, &stat);
+	if (!stat) {
+		stat.perror("create helixData attribute");
+		return stat;
+	}
+	typedAttr.setStorable(true);
+	typedAttr.setHidden(true);
+
+	stat = addAttribute(helixData);
+	if (!stat) {
+		stat.perror("addAttribute helixData");
+		return stat;
+	}
+
+	return MS::kSuccess;
+}
+
+MStatus helixCloudShape::setDependentsDirty(const MPlug& plug, MPlugArray& plugArray)
+{
+	if (plug == helixData)
+		cloudDataChanged();
+
+	return MPxSurfaceShape::setDependentsDirty(plug, plugArray);
+}
+
+const helixCloudData* helixCloudShape::cloudData() const
+	//
+	// Description
+	//     Reads the helices straight from the datablock, as the
+	//     devkit shapes do, so nothing is copied.
+	//
+{
+	MStatus stat;
+	MDataBlock block = const_cast<helixCloudShape*>(this)->forceCache();
+	MDataHandle handle = block.inputValue(helixData, &stat);
+	if (!stat)
+		return NULL;
+	return (const helixCloudData*) handle.asPluginData();
+}
+
+helixCloudData* helixCloudShape::editCloudData()
+	//
+	// Description
+	//     The helices in the datablock itself, so helixToolCmd can add
+	//     and remove helices without copying the rest of the cloud.
+	//     Empty data is made when the shape has none yet.
+	//
+{
+	MStatus stat;
+	if (MPlug(thisMObject(), helixData).isConnected())
+		return NULL;
+
+	MDataBlock block = forceCache();
+	MDataHandle handle = block.outputValue(helixData, &stat);
+	if (!stat)
+		return NULL;
+
+	helixCloudData* data = (helixCloudData*) handle.asPluginData();
+	if (data == NULL) {
+		MFnPluginData dataFn;
+		MObject newData = dataFn.create(helixCloudData::id, &stat);
+		if (!stat)
+			return NULL;
+		handle.set(newData);
+		data = (helixCloudData*) handle.asPluginData();
+	}
+	handle.setClean();
+	return data;
+}
+
+void helixCloudShape::cloudDataChanged()
+	//
+	// Description
+	//     Tells the bounding box and the viewport that the helices have
+	//     changed, whether through the plug or editCloudData().
+	//
+{
+	fRevision++;
+	childChanged(MPxSurfaceShape::kBoundingBoxChanged);
+	MHWRender::MRenderer::setGeometryDrawDirty(thisMObject());
+}
+
+unsigned helixCloudShape::revision() const
+{
+	return fRevision;
+}
+
+bool helixCloudShape::isBounded() const
+{
+	return true;
+}
+
+MBoundingBox helixCloudShape::boundingBox() const
+{
+	const helixCloudData* data = cloudData();
+	if (data == NULL || data->count() == 0)
+		return MBoundingBox(MPoint(0.0, 0.0, 0.0), MPoint(0.0, 0.0, 0.0));
+	return data->bounds();
+}
+
+/////////////////////////////////////////////////////////////
+// helixCloudShapeUI
+/////////////////////////////////////////////////////////////
+
+helixCloudShapeUI::helixCloudShapeUI() {}
+helixCloudShapeUI::~helixCloudShapeUI() {}
+
+void* helixCloudShapeUI::creator()
+{
+	return new helixCloudShapeUI;
+}
+
+bool helixCloudShapeUI::select(MSelectInfo& selectInfo,
+	MSelectionList& selectionList, MPointArray& worldSpaceSelectPts) const
+	//
+	// Description
+	//     Narrows the view's clip space to the selection rectangle and
+	//     culls the cloud's bounds tree with it, so only helices whose
+	//     cylinders reach the rectangle are looked at. A click then
+	//     picks the nearest helix whose curve passes within
+	//     kPickPixels of the pick ray; a marquee takes any helix with
+	//     part of its curve inside.
+	//
+{
+	const helixCloudShape* shape = (const helixCloudShape*) surfaceShape();
+	const helixCloudData* data = shape ? shape->cloudData() : NULL;
+	if (data == NULL || data->count() == 0)
+		return false;
+
+	M3dView view = selectInfo.view();
+	MDagPath path = selectInfo.selectPath();
+	const MMatrix objectToWorld = path.inclusiveMatrix();
+
+	MMatrix viewMatrix, projection;
+	view.modelViewMatrix(viewMatrix);
+	view.projectionMatrix(projection);
+	const MMatrix toClip = objectToWorld * viewMatrix * projection;
+
+	unsigned x, y, width, height;
+	selectInfo.selectRect(x, y, width, height);
+	const double portWidth = (double) view.portWidth();
+	const double portHeight = (double) view.portHeight();
+	if (width == 0 || height == 0 || portWidth <= 0.0 || portHeight <= 0.0)
+		return false;
+
+	// Scale and shift x and y so the rectangle fills clip space.
+	MMatrix toRect = toClip;
+	const double sx = portWidth / (double) width;
+	const double sy = portHeight / (double) height;
+	const double cx = 2.0 * ((double) x + 0.5 * width) / portWidth - 1.0;
+	const double cy = 2.0 * ((double) y + 0.5 * height) / portHeight - 1.0;
+	for (unsigned r = 0; r < 4; r++) {
+		toRect[r][0] = sx * (toClip[r][0] - cx * toClip[r][3]);
+		toRect[r][1] = sy * (toClip[r][1] - cy * toClip[r][3]);
+	}
+
+	helixFrustum frustum;
+	frustum.set(toRect.matrix);
+
+	std::vector<unsigned> candidates;
+	data->boundsTree().cull(frustum, candidates);
+	if (candidates.empty())
+		return false;
+
+	bool found = false;
+	MPoint hitPoint;
+
+	if (selectInfo.singleSelection()) {
+		MPoint rayOrigin;
+		MVector rayDirection;
+		selectInfo.getLocalRay(rayOrigin, rayDirection);
+		rayDirection.normalize();
+
+		// Object space length of a pixel at clip depth w.
+		const double scale = MVector(objectToWorld[0][0], objectToWorld[0][1],
+			objectToWorld[0][2]).length();
+		const double pixel = 2.0 / (projection[1][1] * portHeight * scale);
+
+		double nearest = DBL_MAX;
+		for (size_t c = 0; c < candidates.size(); c++) {
+			const unsigned i = candidates[c];
+			const MMatrix m = data->matrix(i);
+			const MMatrix inverse = m.inverse();
+			const MPoint o = rayOrigin * inverse;
+			const MVector d = rayDirection * inverse;
+			const double rise = (data->flags[i] & helixCloudData::kUpsideDown) ?
+				-data->pitch[i] : data->pitch[i];
+
+			const MPoint centre = MPoint(0.0, 0.5 * rise * (data->numCVs[i] - 1), 0.0) * m;
+			double w = centre.x * toClip[0][3] + centre.y * toClip[1][3] +
+				centre.z * toClip[2][3] + toClip[3][3];
+			if (w <= 0.0)
+				continue;
+
+			const double origin[3] = { o.x, o.y, o.z };
+			const double direction[3] = { d.x, d.y, d.z };
+			double distance, angle, along;
+			if (!helixRayDistance(data->radius[i], rise, data->numCVs[i],
+					origin, direction, kPickPixels * pixel * w,
+					distance, angle, along))
+				continue;
+
+			if (along < nearest) {
+				const double R = helixCurveRadius(data->radius[i]);
+				nearest = along;
+				hitPoint = MPoint(R * cos(angle), rise * angle, R * sin(angle)) * m;
+				found = true;
+			}
+		}
+	}
+	else {
+		std::vector<float> points;
+		for (size_t c = 0; c < candidates.size() && !found; c++) {
+			const unsigned i = candidates[c];
+			const unsigned samples = helixPolylineSamples(data->numCVs[i], kMarqueeSegments);
+			const double rise = (data->flags[i] & helixCloudData::kUpsideDown) ?
+				-data->pitch[i] : data->pitch[i];
+			const MMatrix m = data->matrix(i);
+
+			points.resize(3 * samples);
+			helixPolyline(data->radius[i], rise, data->numCVs[i], samples,
+				m.matrix, &points[0]);
+
+			for (unsigned k = 0; k + 1 < samples; k++) {
+				if (frustum.segmentInside(&points[3 * k], &points[3 * k + 3])) {
+					hitPoint = MPoint(points[3 * k], points[3 * k + 1], points[3 * k + 2]);
+					found = true;
+					break;
+				}
+			}
+		}
+	}
+
+	if (!found)
+		return false;
+
+	MSelectionList item;
+	item.add(path);
+
+	MSelectionMask priorityMask(MSelectionMask::kSelectObjectsMask);
+	selectInfo.addSelection(item, hitPoint * objectToWorld, selectionList,
+		worldSpaceSelectPts, priorityMask, false);
+	return true;
+}
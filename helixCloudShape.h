@@ -0,0 +1,167 @@
+#ifndef _helixCloudShape
+#define _helixCloudShape
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixCloudShape.h
+//
+// Description:
+//     A surface shape holding any number of helices in one DAG node.
+//
+//     Each helix is stored as parameters only, structure-of-arrays, in
+//     a helixCloudData: position, orientation, radius, pitch, number
+//     of CVs and flags, 41 bytes per helix. Geometry is generated on
+//     demand from those parameters in the same way helixTool builds
+//     its CVs.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <maya/MPxData.h>
+#include <maya/MPxSurfaceShape.h>
+#include <maya/MPxSurfaceShapeUI.h>
+#include <maya/MTypeId.h>
+#include <maya/MString.h>
+#include <maya/MArgList.h>
+#include <maya/MBoundingBox.h>
+#include <maya/MPointArray.h>
+#include <maya/MMatrix.h>
+#include <maya/MIOStream.h>
+#include <maya/MSelectInfo.h>
+#include <maya/MSelectionList.h>
+
+#include <vector>
+
+#include "helixBoundsTree.h"
+
+#define kHelixCloudShapeId		0x00081440
+#define kHelixCloudDataId		0x00081441
+
+/////////////////////////////////////////////////////////////
+// helixCloudData
+/////////////////////////////////////////////////////////////
+
+class helixCloudData : public MPxData
+{
+public:
+	enum Flags
+	{
+		kUpsideDown	= 1 << 0
+	};
+
+					helixCloudData();
+	virtual			~helixCloudData();
+	static void*	creator();
+
+	virtual MStatus	readASCII(const MArgList& args, unsigned& lastElement);
+	virtual MStatus	readBinary(istream& in, unsigned length);
+	virtual MStatus	writeASCII(ostream& out);
+	virtual MStatus	writeBinary(ostream& out);
+	virtual void	copy(const MPxData& src);
+	virtual MTypeId	typeId() const;
+	virtual MString	name() const;
+
+	static const MTypeId	id;
+	static const MString	typeName;
+
+	unsigned		count() const;
+	void			reserve(unsigned count);
+	void			resize(unsigned count);
+
+	// Adds a helix placed by the rotation and translation of matrix.
+	// Scale and shear are not stored.
+	void			append(double radius, double pitch, unsigned numCV,
+						bool upsideDown, const MMatrix& matrix);
+
+	MMatrix			matrix(unsigned index) const;
+	void			getCVs(unsigned index, MPointArray& cvs) const;
+	void			helixBounds(unsigned index, float min[3], float max[3]) const;
+	MBoundingBox	bounds() const;
+	void			getCylinder(unsigned index, helixCylinder& cylinder) const;
+
+	// Tree over every helix's bounding cylinder, built on first use
+	// after the helices change.
+	const helixBoundsTree& boundsTree() const;
+
+	static unsigned	bytesPerHelix();
+
+	// Structure-of-arrays storage, one element per helix.
+	std::vector<float>			px, py, pz;			// Position
+	std::vector<float>			qx, qy, qz, qw;		// Orientation
+	std::vector<float>			radius;
+	std::vector<float>			pitch;
+	std::vector<unsigned>		numCVs;
+	std::vector<unsigned char>	flags;
+
+private:
+	bool			validHelices() const;
+
+	mutable MBoundingBox	fBounds;
+	mutable bool			fBoundsDirty;
+	mutable helixBoundsTree	fTree;
+	mutable bool			fTreeDirty;
+};
+
+/////////////////////////////////////////////////////////////
+// helixCloudShape
+/////////////////////////////////////////////////////////////
+
+class helixCloudShape : public MPxSurfaceShape
+{
+public:
+					helixCloudShape();
+	virtual			~helixCloudShape();
+	static void*	creator();
+	static MStatus	initialize();
+
+	virtual MStatus		setDependentsDirty(const MPlug& plug, MPlugArray& plugArray);
+	virtual bool		isBounded() const;
+	virtual MBoundingBox boundingBox() const;
+
+	// The helices of this shape, or NULL when it has none.
+	const helixCloudData* cloudData() const;
+
+	// The helices of this shape, to be changed in place, or NULL when
+	// helixData is connected. Call cloudDataChanged() after changing
+	// them.
+	helixCloudData*	editCloudData();
+	void			cloudDataChanged();
+
+	// Changes whenever helixData is dirtied, so drawing code can tell
+	// whether what it built is still current.
+	unsigned		revision() const;
+
+	static const MTypeId	id;
+	static const MString	typeName;
+
+	static MObject	helixData;		// helixCloudData
+
+private:
+	unsigned		fRevision;
+};
+
+/////////////////////////////////////////////////////////////
+// helixCloudShapeUI
+/////////////////////////////////////////////////////////////
+
+class helixCloudShapeUI : public MPxSurfaceShapeUI
+{
+public:
+					helixCloudShapeUI();
+	virtual			~helixCloudShapeUI();
+	static void*	creator();
+
+	virtual bool	select(MSelectInfo& selectInfo, MSelectionList& selectionList,
+						MPointArray& worldSpaceSelectPts) const;
+};
+
+#endif
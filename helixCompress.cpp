@@ -0,0 +1,151 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixCompress.cpp
+//
+// Description:
+//     A deformer that compresses helices like springs. See
+//     helixCompress.h.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+
+#include <maya/MDataBlock.h>
+#include <maya/MDataHandle.h>
+#include <maya/MItGeometry.h>
+#include <maya/MFnNumericAttribute.h>
+#include <maya/MMatrix.h>
+#include <maya/MPoint.h>
+#include <maya/MPointArray.h>
+
+#include <vector>
+
+#include "helixCompress.h"
+#include "helixGeometry.h"
+
+// Largest RMS distance of the points from the fit, over the radius,
+// for them to be taken as a helix's CVs. As for helixFit.
+#define kFitTolerance	1.0e-3
+
+const MTypeId helixCompress::id( kHelixCompressId );
+const MString helixCompress::typeName( "helixCompress" );
+
+MObject helixCompress::compression;
+MObject helixCompress::preserveVolume;
+
+helixCompress::helixCompress() {}
+helixCompress::~helixCompress() {}
+
+void* helixCompress::creator()
+{
+	return new helixCompress;
+}
+
+MStatus helixCompress::initialize()
+{
+	MStatus stat;
+	MFnNumericAttribute numAttr;
+
+	compression = numAttr.create("compression", "cmp", MFnNumericData::kDouble, 1.0, &stat);
+	numAttr.setKeyable(true);
+	numAttr.setMin(0.01);
+	numAttr.setSoftMax(2.0);
+
+	preserveVolume = numAttr.create("preserveVolume", "pv", MFnNumericData::kBoolean, 0, &stat);
+	numAttr.setKeyable(true);
+
+	MObject* inputs[] = { &compression, &preserveVolume };
+	for (unsigned i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+		stat = addAttribute(*inputs[i]);
+		if (!stat) {
+			stat.perror("addAttribute");
+			return stat;
+		}
+		stat = attributeAffects(*inputs[i], outputGeom);
+		if (!stat) {
+			stat.perror("attributeAffects");
+			return stat;
+		}
+	}
+
+	return MS::kSuccess;
+}
+
+MStatus helixCompress::deform(MDataBlock& data, MItGeometry& iter,
+	const MMatrix& /* localToWorld */, unsigned multiIndex)
+	//
+	// Description
+	//     Takes the points into the helix's space, where it runs up Y
+	//     from the origin, scales them there and brings them back: one
+	//     matrix for all of them. The weighted blend to the scaled
+	//     points is then a single pass over the point array.
+	//
+{
+	MStatus stat;
+
+	const float env = data.inputValue(envelope).asFloat();
+	const double squash = data.inputValue(compression).asDouble();
+	if (env == 0.0f || squash == 1.0)
+		return MS::kSuccess;
+	const double across = data.inputValue(preserveVolume).asBool() ? 1.0 / sqrt(squash) : 1.0;
+
+	MPointArray points;
+	stat = iter.allPositions(points);
+	if (!stat)
+		return stat;
+	const unsigned count = points.length();
+	if (count == 0)
+		return MS::kSuccess;
+
+	std::vector<double> cvs(3 * (size_t) count);
+	for (unsigned i = 0; i < count; i++) {
+		cvs[3 * i] = points[i].x;
+		cvs[3 * i + 1] = points[i].y;
+		cvs[3 * i + 2] = points[i].z;
+	}
+	helixFit fit;
+	fit.fitted = false;
+	if (count >= 4)
+		helixFitCVs((const double (*)[3]) &cvs[0], count, fit);
+
+	MMatrix placement;
+	if (fit.fitted && fit.residual <= kFitTolerance * fit.radius)
+		placement = MMatrix(fit.matrix);
+
+	double scaling[4][4] = {
+		{ across, 0.0, 0.0, 0.0 },
+		{ 0.0, squash, 0.0, 0.0 },
+		{ 0.0, 0.0, across, 0.0 },
+		{ 0.0, 0.0, 0.0, 1.0 } };
+	double m[4][4];
+	(placement.inverse() * MMatrix(scaling) * placement).get(m);
+
+	std::vector<float> weights(count, env);
+	unsigned i = 0;
+	for (iter.reset(); !iter.isDone() && i < count; iter.next(), i++)
+		weights[i] *= weightValue(data, multiIndex, iter.index());
+
+	for (i = 0; i < count; i++) {
+		MPoint& p = points[i];
+		const double w = weights[i];
+		const double x = p.x * m[0][0] + p.y * m[1][0] + p.z * m[2][0] + m[3][0];
+		const double y = p.x * m[0][1] + p.y * m[1][1] + p.z * m[2][1] + m[3][1];
+		const double z = p.x * m[0][2] + p.y * m[1][2] + p.z * m[2][2] + m[3][2];
+		p.x += w * (x - p.x);
+		p.y += w * (y - p.y);
+		p.z += w * (z - p.z);
+	}
+
+	return iter.setAllPositions(points);
+}
@@ -0,0 +1,67 @@
+#ifndef _helixCompress
+#define _helixCompress
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixCompress.h
+//
+// Description:
+//     A deformer that compresses or stretches a helix like a spring:
+//
+//         deformer -type helixCompress helix1;
+//         setAttr helixCompress1.compression 0.5;
+//
+//     compression scales the pitch, so 0.5 halves the helix's height
+//     about its base. With preserveVolume on, the radius grows by one
+//     over the square root of compression, keeping the volume of the
+//     helix's cylinder. Scaling the pitch and radius of a helix is a
+//     scale along and across its axis, so every point moves by the
+//     same matrix, found once per evaluation.
+//
+//     The axis and base come from helixFitCVs() on the input points,
+//     so helixTool curves work wherever their CVs have been moved.
+//     Geometry that is not a helix curve, such as the tool's meshes,
+//     is scaled about its own Y axis through the origin, where the
+//     tool builds helices.
+//
+//     deform() keeps no state on the node, so it is safe to evaluate
+//     in parallel.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <maya/MPxDeformerNode.h>
+#include <maya/MTypeId.h>
+#include <maya/MString.h>
+
+#define kHelixCompressId		0x00081445
+
+class helixCompress : public MPxDeformerNode
+{
+public:
+					helixCompress();
+	virtual			~helixCompress();
+	static void*	creator();
+	static MStatus	initialize();
+
+	virtual MStatus	deform(MDataBlock& data, MItGeometry& iter,
+						const MMatrix& localToWorld, unsigned multiIndex);
+
+	static const MTypeId	id;
+	static const MString	typeName;
+
+	// Inputs
+	static MObject	compression;
+	static MObject	preserveVolume;
+};
+
+#endif
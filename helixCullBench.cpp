@@ -0,0 +1,196 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixCullBench.cpp
+//
+// Description:
+//     A headless benchmark of helixBoundsTree, outside Maya: 1,000,000
+//     helices scattered through a cube are culled against a wide, a
+//     narrow and a distant view, by the tree and by testing every
+//     helix's cylinder in turn. Both must keep the same helices. It is
+//     not part of the plug-in, and the tree needs nothing from Maya:
+//
+//         c++ -O2 helixCullBench.cpp helixBoundsTree.cpp
+//             -o helixCullBench
+//
+//     Usage:
+//
+//         helixCullBench [helices [repeats]]
+//
+//     The fastest of repeats culls is reported for each view.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "helixBoundsTree.h"
+
+#define kBenchHelices		1000000
+#define kBenchRepeats		5
+#define kBenchExtent		5000.0		// Half the side of the cube
+
+static double unit()
+{
+	return (double) rand() / (double) RAND_MAX;
+}
+
+static double seconds(clock_t start)
+{
+	return (double) (clock() - start) / (double) CLOCKS_PER_SEC;
+}
+
+static void perspective(const double eye[3], double fovDegrees,
+	double farClip, double toClip[4][4])
+	//
+	// Description
+	//     A camera at eye looking down -Z with a 4:3 aspect, as an
+	//     OpenGL projection for row vectors (as MMatrix).
+	//
+{
+	const double nearClip = 1.0;
+	const double f = 1.0 / tan(0.5 * fovDegrees * 3.14159265358979 / 180.0);
+	const double projection[4][4] = {
+		{ f * 0.75, 0, 0, 0 },
+		{ 0, f, 0, 0 },
+		{ 0, 0, (farClip + nearClip) / (nearClip - farClip), -1 },
+		{ 0, 0, 2.0 * farClip * nearClip / (nearClip - farClip), 0 } };
+
+	for (unsigned j = 0; j < 3; j++) {
+		for (unsigned k = 0; k < 4; k++)
+			toClip[j][k] = projection[j][k];
+	}
+	for (unsigned k = 0; k < 4; k++) {
+		toClip[3][k] = projection[3][k] - eye[0] * projection[0][k] -
+			eye[1] * projection[1][k] - eye[2] * projection[2][k];
+	}
+}
+
+static bool outside(const helixCylinder& c, const double plane[4])
+	//
+	// Description
+	//     The cylinder test helixBoundsTree applies at its leaves: the
+	//     furthest cap centre plus the caps' reach along the normal.
+	//
+{
+	const double sBase = plane[0] * c.base[0] + plane[1] * c.base[1] +
+		plane[2] * c.base[2] + plane[3];
+	const double sTop = plane[0] * c.top[0] + plane[1] * c.top[1] +
+		plane[2] * c.top[2] + plane[3];
+
+	double length2 = 0.0, along = 0.0, normal2 = 0.0;
+	for (unsigned k = 0; k < 3; k++) {
+		const double axis = c.top[k] - c.base[k];
+		length2 += axis * axis;
+		along += axis * plane[k];
+		normal2 += plane[k] * plane[k];
+	}
+	const double across = (length2 > 0.0) ? normal2 - along * along / length2 : normal2;
+	const double reach = c.radius * sqrt(across > 0.0 ? across : 0.0);
+
+	return std::max(sBase, sTop) + reach < 0.0;
+}
+
+static void cullEach(const std::vector<helixCylinder>& cylinders,
+	const helixFrustum& frustum, std::vector<unsigned>& visible)
+{
+	visible.clear();
+	for (unsigned i = 0; i < (unsigned) cylinders.size(); i++) {
+		bool culled = false;
+		for (unsigned p = 0; p < 6 && !culled; p++)
+			culled = outside(cylinders[i], frustum.planes[p]);
+		if (!culled)
+			visible.push_back(i);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const unsigned helices = (argc > 1) ? (unsigned) atoi(argv[1]) : kBenchHelices;
+	const unsigned repeats = (argc > 2) ? (unsigned) atoi(argv[2]) : kBenchRepeats;
+	if (helices == 0 || repeats == 0) {
+		fprintf(stderr, "usage: %s [helices [repeats]]\n", argv[0]);
+		return 1;
+	}
+
+	srand(1);
+	std::vector<helixCylinder> cylinders(helices);
+	for (unsigned i = 0; i < helices; i++) {
+		helixCylinder& c = cylinders[i];
+		const double height = 2.0 + 30.0 * unit();
+		const double axis[3] = { 0.4 * (unit() - 0.5), 1.0, 0.4 * (unit() - 0.5) };
+		const double length = sqrt(axis[0] * axis[0] + 1.0 + axis[2] * axis[2]);
+		for (unsigned k = 0; k < 3; k++) {
+			c.base[k] = (float) (kBenchExtent * (2.0 * unit() - 1.0));
+			c.top[k] = (float) (c.base[k] + height * axis[k] / length);
+		}
+		c.radius = (float) (0.5 + 4.0 * unit());
+	}
+
+	helixBoundsTree tree;
+	clock_t start = clock();
+	tree.build(cylinders);
+	printf("%u helices: tree built in %.1f ms\n", helices, 1000.0 * seconds(start));
+
+	struct View
+	{
+		const char*	name;
+		double		eye[3];
+		double		fov;
+		double		farClip;
+	};
+	const View views[] = {
+		{ "wide",    { 0.0, 0.0, 2.0 * kBenchExtent }, 60.0, 4.0 * kBenchExtent },
+		{ "narrow",  { 0.0, 0.0, 0.0 },                10.0, 2.0 * kBenchExtent },
+		{ "distant", { 0.0, 0.0, 0.5 * kBenchExtent }, 30.0, 1000.0 }
+	};
+
+	bool same = true;
+	for (unsigned v = 0; v < sizeof(views) / sizeof(views[0]); v++) {
+		double toClip[4][4];
+		perspective(views[v].eye, views[v].fov, views[v].farClip, toClip);
+		helixFrustum frustum;
+		frustum.set(toClip);
+
+		std::vector<unsigned> byTree, byEach;
+		double treeTime = 0.0, eachTime = 0.0;
+		for (unsigned r = 0; r < repeats; r++) {
+			start = clock();
+			tree.cull(frustum, byTree);
+			const double t = seconds(start);
+			if (r == 0 || t < treeTime)
+				treeTime = t;
+
+			start = clock();
+			cullEach(cylinders, frustum, byEach);
+			const double e = seconds(start);
+			if (r == 0 || e < eachTime)
+				eachTime = e;
+		}
+
+		std::sort(byTree.begin(), byTree.end());
+		const bool match = byTree == byEach;
+		same = same && match;
+
+		printf("%-8s %7u kept: tree %.2f ms, each helix %.2f ms, %.1fx%s\n",
+			views[v].name, (unsigned) byTree.size(), 1000.0 * treeTime,
+			1000.0 * eachTime, treeTime > 0.0 ? eachTime / treeTime : 0.0,
+			match ? "" : ", RESULTS DIFFER");
+	}
+	return same ? 0 : 1;
+}
@@ -0,0 +1,305 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixDrawTest.cpp
+//
+// Description:
+//     Checks the parts of helixCloud drawing that need no viewport:
+//     the level of detail chosen for a helix's size on screen, the
+//     polyline written for each level, and view culling with the
+//     bounds tree. It is not part of the plug-in, and needs no GPU
+//     and no running Maya, only the libraries helixGeometry links
+//     against:
+//
+//         c++ -O2 -I$MAYA_LOCATION/include helixDrawTest.cpp
+//             helixGeometry.cpp helixBoundsTree.cpp
+//             -L$MAYA_LOCATION/lib -lOpenMaya -lFoundation
+//             -o helixDrawTest
+//
+//     It prints each failed check and exits with 1 if there were
+//     any, 0 otherwise.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "helixGeometry.h"
+#include "helixBoundsTree.h"
+
+static unsigned failures = 0;
+
+static void check(bool ok, const char* what)
+{
+	if (!ok) {
+		printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+/////////////////////////////////////////////////////////////
+// Levels of detail
+/////////////////////////////////////////////////////////////
+
+static void testLod()
+{
+	check(helixLodSegmentsPerRadian(0.0) == 0, "lod: no segments below a pixel");
+	check(helixLodSegmentsPerRadian(0.5) == 0, "lod: no segments below a pixel");
+	check(helixLodSegmentsPerRadian(sqrt(-1.0)) == 0, "lod: no segments for NaN");
+
+	unsigned last = 0;
+	bool powers = true, rising = true;
+	for (double pixels = 1.0; pixels < 1.0e6; pixels *= 1.1) {
+		const unsigned level = helixLodSegmentsPerRadian(pixels);
+		if (level == 0 || level > 16 || (level & (level - 1)) != 0)
+			powers = false;
+		if (level < last)
+			rising = false;
+		last = level;
+	}
+	check(powers, "lod: a power of two from 1 to 16 from a pixel up");
+	check(rising, "lod: never coarser for a larger helix");
+	check(last == 16, "lod: 16 segments per radian for huge helices");
+
+	check(helixPolylineSamples(40, 0) == 2, "samples: level 0 is the axis");
+	check(helixPolylineSamples(40, 1) == 38, "samples: one per radian");
+	check(helixPolylineSamples(40, 16) == 37 * 16 + 1, "samples: 16 per radian");
+	check(helixPolylineSamples(3, 4) == 2, "samples: too few CVs for a curve");
+	check(helixPolylineSamples(0xffffffffu, 16) == (1u << 24),
+		"samples: capped rather than wrapped for huge helices");
+}
+
+/////////////////////////////////////////////////////////////
+// Polylines
+/////////////////////////////////////////////////////////////
+
+static void testPolyline()
+	//
+	// Description
+	//     At one segment per radian the polyline's points fall on the
+	//     knots of the helix's degree 3 curve, where a uniform cubic
+	//     B-spline is (P[i-1] + 4 P[i] + P[i+1]) / 6 of its CVs.
+	//
+{
+	const double identity[4][4] = {
+		{ 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } };
+	const unsigned numCVs = 60;
+	const double radius = 3.0, rise = -0.4;
+
+	std::vector<double> cvs(4 * numCVs);
+	helixCurve(radius, radius, rise, NULL, numCVs, (double (*)[4]) &cvs[0], NULL);
+
+	const unsigned samples = helixPolylineSamples(numCVs, 1);
+	std::vector<float> xyz(3 * samples);
+	helixPolyline(radius, rise, numCVs, samples, identity, &xyz[0]);
+
+	double worst = 0.0;
+	for (unsigned k = 0; k < samples; k++) {
+		const unsigned i = k + 1;
+		for (unsigned a = 0; a < 3; a++) {
+			const double knot = (cvs[4 * (i - 1) + a] + 4.0 * cvs[4 * i + a] +
+				cvs[4 * (i + 1) + a]) / 6.0;
+			worst = std::max(worst, fabs(knot - xyz[3 * k + a]));
+		}
+	}
+	check(worst < 1.0e-4, "polyline: points on the curve's knots");
+
+	// Finer levels stay on the same circle and climb evenly.
+	const unsigned fine = helixPolylineSamples(numCVs, 16);
+	xyz.resize(3 * fine);
+	helixPolyline(radius, rise, numCVs, fine, identity, &xyz[0]);
+	const double curveRadius = helixCurveRadius(radius);
+	bool onCircle = true, even = true;
+	for (unsigned k = 0; k < fine; k++) {
+		const double r = sqrt(xyz[3 * k] * xyz[3 * k] + xyz[3 * k + 2] * xyz[3 * k + 2]);
+		const double t = 1.0 + (double) k / 16.0;
+		if (fabs(r - curveRadius) > 1.0e-4)
+			onCircle = false;
+		if (fabs(xyz[3 * k + 1] - rise * t) > 1.0e-4)
+			even = false;
+	}
+	check(onCircle, "polyline: fine levels on the curve radius");
+	check(even, "polyline: fine levels climb evenly");
+
+	// Level 0 is the axis, bottom to top, placed by the matrix.
+	const double moved[4][4] = {
+		{ 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 5, 6, 7, 1 } };
+	float axis[6];
+	helixPolyline(radius, rise, numCVs, helixPolylineSamples(numCVs, 0), moved, axis);
+	check(axis[0] == 5.0f && axis[2] == 7.0f && axis[3] == 5.0f && axis[5] == 7.0f,
+		"polyline: level 0 runs up the axis");
+	check(fabs(axis[1] - (6.0 + rise)) < 1.0e-5 &&
+		fabs(axis[4] - (6.0 + rise * (numCVs - 2))) < 1.0e-4,
+		"polyline: level 0 spans the curve's height");
+}
+
+/////////////////////////////////////////////////////////////
+// Culling
+/////////////////////////////////////////////////////////////
+
+static double unit()
+{
+	return (double) rand() / (double) RAND_MAX;
+}
+
+static void perspective(const double eye[3], double toClip[4][4])
+	//
+	// Description
+	//     A camera at eye looking down -Z, 60 degrees high with a 4:3
+	//     aspect, as an OpenGL projection for row vectors.
+	//
+{
+	const double nearClip = 1.0, farClip = 500.0;
+	const double f = 1.0 / tan(30.0 * 3.14159265358979 / 180.0);
+	double projection[4][4] = {
+		{ f * 0.75, 0, 0, 0 },
+		{ 0, f, 0, 0 },
+		{ 0, 0, (farClip + nearClip) / (nearClip - farClip), -1 },
+		{ 0, 0, 2.0 * farClip * nearClip / (nearClip - farClip), 0 } };
+
+	// Translating by -eye first only changes the last row.
+	for (unsigned j = 0; j < 4; j++) {
+		for (unsigned k = 0; k < 4; k++)
+			toClip[j][k] = projection[j][k];
+	}
+	for (unsigned k = 0; k < 4; k++) {
+		toClip[3][k] = projection[3][k] - eye[0] * projection[0][k] -
+			eye[1] * projection[1][k] - eye[2] * projection[2][k];
+	}
+}
+
+static bool pointInside(const helixFrustum& frustum, const double p[3])
+{
+	for (unsigned i = 0; i < 6; i++) {
+		const double* plane = frustum.planes[i];
+		if (plane[0] * p[0] + plane[1] * p[1] + plane[2] * p[2] + plane[3] < 0.0)
+			return false;
+	}
+	return true;
+}
+
+static bool cylinderSeen(const helixCylinder& c, const helixFrustum& frustum)
+	//
+	// Description
+	//     Whether any of a ring of points on the cylinder's axis and
+	//     walls is inside the frustum. A helix this finds must never
+	//     be culled.
+	//
+{
+	double axis[3] = { c.top[0] - c.base[0], c.top[1] - c.base[1], c.top[2] - c.base[2] };
+	double u[3] = { 1.0, 0.0, 0.0 };
+	if (fabs(axis[0]) > fabs(axis[1]) && fabs(axis[0]) > fabs(axis[2])) {
+		u[0] = 0.0;
+		u[1] = 1.0;
+	}
+	// v = axis x u and w = v x axis span the plane across the axis.
+	double v[3] = { axis[1] * u[2] - axis[2] * u[1],
+		axis[2] * u[0] - axis[0] * u[2], axis[0] * u[1] - axis[1] * u[0] };
+	double w[3] = { v[1] * axis[2] - v[2] * axis[1],
+		v[2] * axis[0] - v[0] * axis[2], v[0] * axis[1] - v[1] * axis[0] };
+	const double lv = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+	const double lw = sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+
+	for (unsigned s = 0; s <= 8; s++) {
+		for (unsigned a = 0; a <= 16; a++) {
+			const double along = s / 8.0;
+			const double angle = 6.283185307179586 * a / 16.0;
+			const double across = (a == 16) ? 0.0 : c.radius;
+			double p[3];
+			for (unsigned k = 0; k < 3; k++) {
+				p[k] = c.base[k] + along * axis[k] +
+					across * (cos(angle) * v[k] / lv + sin(angle) * w[k] / lw);
+			}
+			if (pointInside(frustum, p))
+				return true;
+		}
+	}
+	return false;
+}
+
+static void testCulling()
+	//
+	// Description
+	//     Culls random helices against a camera, and compares the
+	//     tree's answer with each helix culled on its own.
+	//
+{
+	srand(1);
+	const unsigned count = 4000;
+	std::vector<helixCylinder> cylinders(count);
+	for (unsigned i = 0; i < count; i++) {
+		helixCylinder& c = cylinders[i];
+		const double height = 1.0 + 20.0 * unit();
+		double axis[3] = { unit() - 0.5, unit(), unit() - 0.5 };
+		const double length = sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		for (unsigned k = 0; k < 3; k++) {
+			c.base[k] = (float) (400.0 * unit() - 200.0);
+			c.top[k] = (float) (c.base[k] + height * axis[k] / length);
+		}
+		c.radius = (float) (0.5 + 4.0 * unit());
+	}
+
+	helixBoundsTree tree;
+	tree.build(cylinders);
+	check(tree.size() == count, "cull: tree holds every helix");
+
+	const double eyes[3][3] = { { 0, 0, 250 }, { 120, 40, 0 }, { 0, 0, 650 } };
+	for (unsigned e = 0; e < 3; e++) {
+		double toClip[4][4];
+		perspective(eyes[e], toClip);
+		helixFrustum frustum;
+		frustum.set(toClip);
+
+		std::vector<unsigned> visible;
+		tree.cull(frustum, visible);
+		std::sort(visible.begin(), visible.end());
+		check(std::adjacent_find(visible.begin(), visible.end()) == visible.end(),
+			"cull: no helix listed twice");
+
+		std::vector<unsigned> alone, seen;
+		helixBoundsTree single;
+		for (unsigned i = 0; i < count; i++) {
+			std::vector<helixCylinder> one(1, cylinders[i]);
+			std::vector<unsigned> kept;
+			single.build(one);
+			single.cull(frustum, kept);
+			if (!kept.empty())
+				alone.push_back(i);
+			if (cylinderSeen(cylinders[i], frustum))
+				seen.push_back(i);
+		}
+
+		check(visible == alone, "cull: the tree keeps exactly the helices kept one by one");
+		check(std::includes(visible.begin(), visible.end(), seen.begin(), seen.end()),
+			"cull: no helix with a point in view is culled");
+		printf("view %u: %u of %u helices kept, %u with sampled points in view\n",
+			e, (unsigned) visible.size(), count, (unsigned) seen.size());
+	}
+}
+
+int main()
+{
+	testLod();
+	testPolyline();
+	testCulling();
+
+	if (failures)
+		printf("%u checks failed\n", failures);
+	else
+		printf("all checks passed\n");
+	return failures ? 1 : 0;
+}
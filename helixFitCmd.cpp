@@ -0,0 +1,230 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixFitCmd.cpp
+//
+// Description:
+//     Fits helixTool helices to existing curves. See helixFitCmd.h.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <maya/MArgList.h>
+#include <maya/MArgDatabase.h>
+#include <maya/MGlobal.h>
+#include <maya/MSelectionList.h>
+#include <maya/MItSelectionList.h>
+#include <maya/MDagPath.h>
+#include <maya/MFnNurbsCurve.h>
+#include <maya/MFnTransform.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MTransformationMatrix.h>
+#include <maya/MPlug.h>
+#include <maya/MPointArray.h>
+#include <maya/MDoubleArray.h>
+
+#include "helixFitCmd.h"
+#include "helixGeometry.h"
+#include "helixNode.h"
+
+#define kToleranceFlag		"-tol"
+#define kToleranceFlagLong	"-tolerance"
+#define kConvertFlag		"-cnv"
+#define kConvertFlagLong	"-convert"
+
+// Largest RMS distance of the CVs from the fit, over the radius, for
+// a curve to count as a helix.
+#define kDefaultTolerance	1.0e-3
+
+const MString helixFitCmd::commandName( "helixFit" );
+
+helixFitCmd::helixFitCmd()
+{
+	convert = false;
+}
+
+helixFitCmd::~helixFitCmd() {}
+
+void* helixFitCmd::creator()
+{
+	return new helixFitCmd;
+}
+
+MSyntax helixFitCmd::newSyntax()
+{
+	MSyntax syntax;
+
+	syntax.addFlag(kToleranceFlag, kToleranceFlagLong, MSyntax::kDouble);
+	syntax.addFlag(kConvertFlag, kConvertFlagLong, MSyntax::kBoolean);
+
+	// Curves to fit; the selection is used when none are given.
+	syntax.setObjectType(MSyntax::kSelectionList, 0);
+
+	return syntax;
+}
+
+MStatus helixFitCmd::doIt(const MArgList& args)
+	//
+	// Description
+	//     Reads the CVs of every curve on the main thread, fits them
+	//     all at once on the thread pool, then queues the conversion
+	//     of the curves that fit for redoIt.
+	//
+{
+	MStatus stat;
+	MArgDatabase argData(syntax(), args, &stat);
+	if (!stat)
+		return stat;
+
+	double tolerance = kDefaultTolerance;
+	if (argData.isFlagSet(kToleranceFlag)) {
+		stat = argData.getFlagArgument(kToleranceFlag, 0, tolerance);
+		if (!stat || !(tolerance > 0.0)) {
+			MGlobal::displayError("tolerance must be greater than 0");
+			return MS::kInvalidParameter;
+		}
+	}
+	if (argData.isFlagSet(kConvertFlag)) {
+		stat = argData.getFlagArgument(kConvertFlag, 0, convert);
+		if (!stat) {
+			stat.perror("convert flag parsing failed");
+			return stat;
+		}
+	}
+
+	MSelectionList list;
+	argData.getObjects(list);
+	if (list.length() == 0)
+		MGlobal::getActiveSelectionList(list);
+
+	std::vector<MDagPath> curves;
+	std::vector<double> cvs;
+	std::vector<unsigned> offsets(1, 0);
+	for (MItSelectionList iter(list); !iter.isDone(); iter.next()) {
+		MDagPath path;
+		if (!iter.getDagPath(path) || !path.extendToShape() ||
+			!path.hasFn(MFn::kNurbsCurve))
+			continue;
+
+		MPointArray points;
+		MFnNurbsCurve(path).getCVs(points, MSpace::kObject);
+		for (unsigned i = 0; i < points.length(); i++) {
+			cvs.push_back(points[i].x);
+			cvs.push_back(points[i].y);
+			cvs.push_back(points[i].z);
+		}
+		offsets.push_back((unsigned) (cvs.size() / 3));
+		curves.push_back(path);
+	}
+
+	if (curves.empty()) {
+		MGlobal::displayError("helixFit: no curves given or selected");
+		return MS::kInvalidParameter;
+	}
+
+	std::vector<helixFit> fits(curves.size());
+	helixFitBatch((const double (*)[3]) &cvs[0], &offsets[0],
+		(unsigned) curves.size(), &fits[0]);
+
+	MDoubleArray result;
+	unsigned skipped = 0;
+	for (unsigned c = 0; c < curves.size(); c++) {
+		const helixFit& fit = fits[c];
+		const bool helical = fit.fitted && fit.residual <= tolerance * fit.radius;
+
+		result.append(helical ? fit.radius : 0.0);
+		result.append(helical ? fit.pitch : 0.0);
+		result.append(helical ? (double) fit.numCVs : 0.0);
+		result.append(helical && fit.upsideDown ? 1.0 : 0.0);
+		result.append(helical ? fit.residual : -1.0);
+
+		if (!helical || !convert)
+			continue;
+
+		// The transform takes the fit's placement, which would move
+		// any other shapes under it; and a curve with history keeps it.
+		MObject shape = curves[c].node();
+		MFnDependencyNode shapeFn(shape);
+		MPlug create = shapeFn.findPlug("create");
+		MObject transform = curves[c].transform();
+		if (create.isConnected() || MFnDagNode(transform).childCount() != 1) {
+			skipped++;
+			continue;
+		}
+
+		MObject node = dgMod.createNode(helixNode::id, &stat);
+		if (stat)
+			stat = dgMod.connect(node, helixNode::outputCurve, shape, create.attribute());
+		if (stat)
+			stat = dgMod.newPlugValueDouble(MPlug(node, helixNode::radius), fit.radius);
+		if (stat)
+			stat = dgMod.newPlugValueDouble(MPlug(node, helixNode::pitch), fit.pitch);
+		if (stat)
+			stat = dgMod.newPlugValueInt(MPlug(node, helixNode::numCVs), (int) fit.numCVs);
+		if (stat)
+			stat = dgMod.newPlugValueBool(MPlug(node, helixNode::upsideDown), fit.upsideDown);
+		if (!stat) {
+			stat.perror("helixFit: converting " + curves[c].partialPathName());
+			return stat;
+		}
+
+		// The helix lives in the curve's old object space, so the
+		// fit's matrix goes in front of the transform's own.
+		MMatrix local = MFnTransform(transform).transformation().asMatrix();
+		transforms.append(transform);
+		oldMatrices.push_back(local);
+		newMatrices.push_back(MMatrix(fit.matrix) * local);
+	}
+
+	if (skipped > 0) {
+		MString msg("helixFit: left ");
+		msg += skipped;
+		msg += " curves with history or sharing a transform unconverted";
+		displayWarning(msg);
+	}
+
+	setResult(result);
+	return convert ? redoIt() : MS::kSuccess;
+}
+
+MStatus helixFitCmd::redoIt()
+{
+	MStatus stat = dgMod.doIt();
+	if (!stat)
+		return stat;
+
+	for (unsigned i = 0; i < transforms.length(); i++) {
+		MFnTransform transformFn(transforms[i]);
+		stat = transformFn.set(MTransformationMatrix(newMatrices[i]));
+		if (!stat)
+			return stat;
+	}
+	return MS::kSuccess;
+}
+
+MStatus helixFitCmd::undoIt()
+{
+	for (unsigned i = 0; i < transforms.length(); i++) {
+		MFnTransform transformFn(transforms[i]);
+		transformFn.set(MTransformationMatrix(oldMatrices[i]));
+	}
+	return dgMod.undoIt();
+}
+
+bool helixFitCmd::isUndoable() const
+	//
+	// Description
+	//     Fitting alone changes nothing; converting is undoable.
+	//
+{
+	return convert;
+}
@@ -0,0 +1,65 @@
+#ifndef _helixFitCmd
+#define _helixFitCmd
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixFitCmd.h
+//
+// Description:
+//     The helixFit command recovers helixTool parameters from existing
+//     curves: radius, pitch, numCVs, upsideDown and the placement of
+//     the helix, by the least squares fit of helixFitCVs().
+//
+//         helixFit [-tolerance t] [-convert true] [curves]
+//
+//     The result holds five values per curve: radius, pitch, numCVs,
+//     upsideDown and the RMS distance of the CVs from the fit, or -1
+//     for curves that are not helices to within t times their radius.
+//     With -convert, each fitted curve is driven by a new helixNode,
+//     and its transform takes the fitted placement, so that the scene
+//     stores four parameters in place of the CVs. Undoable.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <maya/MPxCommand.h>
+#include <maya/MSyntax.h>
+#include <maya/MDGModifier.h>
+#include <maya/MObjectArray.h>
+#include <maya/MMatrix.h>
+
+#include <vector>
+
+class helixFitCmd : public MPxCommand
+{
+public:
+					helixFitCmd();
+	virtual			~helixFitCmd();
+	static void*	creator();
+	static MSyntax	newSyntax();
+
+	virtual MStatus	doIt(const MArgList& args);
+	virtual MStatus	redoIt();
+	virtual MStatus	undoIt();
+	virtual bool	isUndoable() const;
+
+	static const MString	commandName;
+
+private:
+	bool			convert;		// Replace fitted curves' CVs
+	MDGModifier		dgMod;			// helixNodes and their connections
+	MObjectArray	transforms;		// Transforms of converted curves
+	std::vector<MMatrix> oldMatrices;	// Their matrices before
+	std::vector<MMatrix> newMatrices;	// Their matrices after
+};
+
+#endif
@@ -0,0 +1,1704 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixGeometry.cpp
+//
+// Description:
+//     Analytic helix geometry. See helixGeometry.h.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <float.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <utility>
+
+#include <maya/MThreadPool.h>
+
+#include "helixGeometry.h"
+
+#define PI 3.1415926535897932
+
+/////////////////////////////////////////////////////////////
+// Spring topology cache
+/////////////////////////////////////////////////////////////
+
+typedef std::pair<unsigned, unsigned> helixTopologyKey;
+typedef std::map<helixTopologyKey, helixSpringTopology*> helixTopologyMap;
+
+static helixTopologyMap topologies;
+
+// Batches usually share a handful of (segments, sides) pairs; beyond
+// this many the cache is simply emptied rather than grown.
+static const size_t kMaxCachedTopologies = 32;
+
+static helixSpringTopology* buildSpringTopology(unsigned segments, unsigned sides)
+{
+	helixSpringTopology* topo = new helixSpringTopology;
+
+	const unsigned rings = segments + 1;
+	const unsigned uvRing = sides + 1;
+
+	topo->segments = segments;
+	topo->sides = sides;
+	topo->numVertices = (int) (rings * sides);
+	topo->numPolygons = (int) (segments * sides);
+
+	topo->polygonCounts.setLength(segments * sides);
+	topo->polygonConnects.setLength(segments * sides * 4);
+	topo->uvCounts.setLength(segments * sides);
+	topo->uvIds.setLength(segments * sides * 4);
+	topo->uArray.setLength(rings * uvRing);
+	topo->vArray.setLength(rings * uvRing);
+	topo->vertexList.setLength(rings * sides);
+
+	unsigned i, j;
+
+	for (i = 0; i < rings; i++) {
+		for (j = 0; j < uvRing; j++) {
+			topo->uArray[i * uvRing + j] = (float) j / (float) sides;
+			topo->vArray[i * uvRing + j] = (float) i / (float) segments;
+		}
+	}
+
+	for (i = 0; i < rings * sides; i++)
+		topo->vertexList[i] = (int) i;
+
+	// Faces wind a -> b -> c -> d, around the tube and then along it,
+	// which makes them face away from the centre line.
+	//
+	unsigned face = 0;
+	for (i = 0; i < segments; i++) {
+		for (j = 0; j < sides; j++, face++) {
+			unsigned next = (j + 1) % sides;
+
+			topo->polygonCounts[face] = 4;
+			topo->polygonConnects[4 * face + 0] = (int) (i * sides + j);
+			topo->polygonConnects[4 * face + 1] = (int) (i * sides + next);
+			topo->polygonConnects[4 * face + 2] = (int) ((i + 1) * sides + next);
+			topo->polygonConnects[4 * face + 3] = (int) ((i + 1) * sides + j);
+
+			topo->uvCounts[face] = 4;
+			topo->uvIds[4 * face + 0] = (int) (i * uvRing + j);
+			topo->uvIds[4 * face + 1] = (int) (i * uvRing + j + 1);
+			topo->uvIds[4 * face + 2] = (int) ((i + 1) * uvRing + j + 1);
+			topo->uvIds[4 * face + 3] = (int) ((i + 1) * uvRing + j);
+		}
+	}
+
+	return topo;
+}
+
+const helixSpringTopology& helixGetSpringTopology(unsigned segments, unsigned sides)
+{
+	helixTopologyKey key(segments, sides);
+
+	helixTopologyMap::iterator found = topologies.find(key);
+	if (found != topologies.end())
+		return *found->second;
+
+	if (topologies.size() >= kMaxCachedTopologies)
+		helixClearSpringTopologies();
+
+	helixSpringTopology* topo = buildSpringTopology(segments, sides);
+	topologies[key] = topo;
+	return *topo;
+}
+
+void helixClearSpringTopologies()
+{
+	for (helixTopologyMap::iterator it = topologies.begin(); it != topologies.end(); ++it)
+		delete it->second;
+	topologies.clear();
+}
+
+/////////////////////////////////////////////////////////////
+// Spring vertices
+/////////////////////////////////////////////////////////////
+
+static void springSideTables(unsigned sides, std::vector<double>& cosPhi,
+	std::vector<double>& sinPhi)
+{
+	cosPhi.resize(sides);
+	sinPhi.resize(sides);
+	for (unsigned j = 0; j < sides; j++) {
+		double phi = 2.0 * PI * (double) j / (double) sides;
+		cosPhi[j] = cos(phi);
+		sinPhi[j] = sin(phi);
+	}
+}
+
+static void springRingRange(const helixSpringDesc& desc,
+	const double* cosPhi, const double* sinPhi,
+	unsigned firstRing, unsigned endRing,
+	float (*points)[4], double (*normals)[3])
+	//
+	// Description
+	//     Each ring is a circle of tubeRadius in the normal plane of
+	//     the centre line. For the helix (R cos t, h t, R sin t) the
+	//     Frenet frame is known in closed form:
+	//
+	//         T = (-R sin t, h, R cos t) / L      L = sqrt(R^2 + h^2)
+	//         N = (-cos t, 0, -sin t)
+	//         B = T x N = (-h sin t, -R, h cos t) / L
+	//
+	//     so a ring costs one sin/cos pair, and the loop over its
+	//     vertices is plain arithmetic the compiler can vectorise.
+	//     A ring depends only on its index, never on its neighbours.
+	//
+{
+	const unsigned sides = desc.sides;
+	const double R = desc.radius;
+	const double h = desc.rise;
+	const double r = desc.tubeRadius;
+	const double invL = 1.0 / sqrt(R * R + h * h);
+	const double step = (desc.segments > 0) ?
+		(desc.endAngle - desc.startAngle) / (double) desc.segments : 0.0;
+
+	for (unsigned i = firstRing; i < endRing; i++) {
+		const double t = desc.startAngle + step * (double) i;
+		const double ct = cos(t);
+		const double st = sin(t);
+
+		const double cx = R * ct, cy = h * t, cz = R * st;
+		const double nx = -ct, nz = -st;
+		const double bx = -h * st * invL, by = -R * invL, bz = h * ct * invL;
+
+		float (*ringPoints)[4] = points + (size_t) i * sides;
+		double (*ringNormals)[3] = normals + (size_t) i * sides;
+
+		for (unsigned j = 0; j < sides; j++) {
+			const double ox = cosPhi[j] * nx + sinPhi[j] * bx;
+			const double oy = sinPhi[j] * by;
+			const double oz = cosPhi[j] * nz + sinPhi[j] * bz;
+
+			ringNormals[j][0] = ox;
+			ringNormals[j][1] = oy;
+			ringNormals[j][2] = oz;
+
+			ringPoints[j][0] = (float) (cx + r * ox);
+			ringPoints[j][1] = (float) (cy + r * oy);
+			ringPoints[j][2] = (float) (cz + r * oz);
+			ringPoints[j][3] = 1.0f;
+		}
+	}
+}
+
+void helixSpringRings(const helixSpringDesc& desc,
+	unsigned firstRing, unsigned endRing,
+	float (*points)[4], double (*normals)[3])
+{
+	std::vector<double> cosPhi, sinPhi;
+	springSideTables(desc.sides, cosPhi, sinPhi);
+	springRingRange(desc, &cosPhi[0], &sinPhi[0], firstRing, endRing, points, normals);
+}
+
+/////////////////////////////////////////////////////////////
+// Threaded spring vertices
+/////////////////////////////////////////////////////////////
+
+// Below this many vertices a spring is cheaper to build on the
+// calling thread than to hand to the pool.
+static const unsigned kParallelSpringVertices = 32768;
+
+// Vertices per task. Small enough to balance the load over the
+// pool, large enough that each task amortises its scheduling cost.
+static const unsigned kSpringVerticesPerTask = 16384;
+
+struct springRingTask
+{
+	const helixSpringDesc*	desc;
+	const double*			cosPhi;
+	const double*			sinPhi;
+	unsigned				firstRing;
+	unsigned				endRing;
+	float					(*points)[4];
+	double					(*normals)[3];
+};
+
+struct springRingJob
+{
+	std::vector<springRingTask> tasks;
+};
+
+static MThreadRetVal springRingTaskFunc(void* data)
+{
+	springRingTask* task = (springRingTask*) data;
+	springRingRange(*task->desc, task->cosPhi, task->sinPhi,
+		task->firstRing, task->endRing, task->points, task->normals);
+	return 0;
+}
+
+static void springRingDecompose(void* data, MThreadRootTask* root)
+{
+	springRingJob* job = (springRingJob*) data;
+	for (size_t i = 0; i < job->tasks.size(); i++)
+		MThreadPool::createTask(springRingTaskFunc, (void*) &job->tasks[i], root);
+	MThreadPool::executeAndJoin(root);
+}
+
+void helixSpringRingsParallel(const helixSpringDesc& desc,
+	float (*points)[4], double (*normals)[3])
+{
+	const unsigned rings = desc.segments + 1;
+
+	std::vector<double> cosPhi, sinPhi;
+	springSideTables(desc.sides, cosPhi, sinPhi);
+
+	if ((size_t) rings * desc.sides < kParallelSpringVertices) {
+		springRingRange(desc, &cosPhi[0], &sinPhi[0], 0, rings, points, normals);
+		return;
+	}
+
+	unsigned ringsPerTask = kSpringVerticesPerTask / desc.sides;
+	if (ringsPerTask == 0)
+		ringsPerTask = 1;
+
+	springRingJob job;
+	for (unsigned first = 0; first < rings; first += ringsPerTask) {
+		springRingTask task;
+		task.desc = &desc;
+		task.cosPhi = &cosPhi[0];
+		task.sinPhi = &sinPhi[0];
+		task.firstRing = first;
+		task.endRing = (rings - first < ringsPerTask) ? rings : first + ringsPerTask;
+		task.points = points;
+		task.normals = normals;
+		job.tasks.push_back(task);
+	}
+
+	if (!MThreadPool::newParallelRegion(springRingDecompose, (void*) &job)) {
+		// Without a pool, do the same work here.
+		springRingRange(desc, &cosPhi[0], &sinPhi[0], 0, rings, points, normals);
+	}
+}
+
+/////////////////////////////////////////////////////////////
+// Polylines
+/////////////////////////////////////////////////////////////
+
+static const unsigned kMaxSegmentsPerRadian = 16;
+
+// Most points in one helix's polyline. Longer helices are drawn with
+// fewer segments per radian.
+static const unsigned kMaxPolylineSamples = 1u << 24;
+
+unsigned helixLodSegmentsPerRadian(double pixelRadius)
+{
+	if (!(pixelRadius >= 1.0))
+		return 0;
+
+	// A radian of arc is pixelRadius pixels long.
+	double wanted = pixelRadius / 4.0;
+
+	unsigned level = 1;
+	while (level < kMaxSegmentsPerRadian && (double) level < wanted)
+		level *= 2;
+	return level;
+}
+
+unsigned helixPolylineSamples(unsigned numCVs, unsigned segmentsPerRadian)
+{
+	if (segmentsPerRadian == 0 || numCVs < 4)
+		return 2;
+
+	// Worked out in double, so that no count of CVs can wrap.
+	if ((double) (numCVs - 3) * (double) segmentsPerRadian >= (double) kMaxPolylineSamples)
+		return kMaxPolylineSamples;
+	return (numCVs - 3) * segmentsPerRadian + 1;
+}
+
+void helixPolyline(double cvRadius, double rise, unsigned numCVs,
+	unsigned samples, const double matrix[4][4], float* xyz)
+	//
+	// Description
+	//     The angle runs from 1 to numCVs - 2 as on the curve itself.
+	//     Each point is rotated from the last by a fixed step rather
+	//     than calling cos and sin per point; in double precision the
+	//     drift over any realistic number of samples is far below
+	//     float resolution.
+	//
+{
+	if (samples == 0)
+		return;
+
+	const double R = helixCurveRadius(cvRadius);
+	const double first = 1.0;
+	const double last = (numCVs > 3) ? (double) (numCVs - 2) : first;
+	const double step = (samples > 1) ? (last - first) / (double) (samples - 1) : 0.0;
+	const double cs = cos(step), ss = sin(step);
+
+	// Level 0 is just the axis, bottom to top.
+	const bool axisOnly = (samples == 2 && numCVs > 4);
+
+	double c = cos(first), s = sin(first);
+	for (unsigned i = 0; i < samples; i++) {
+		const double t = first + step * (double) i;
+		const double x = axisOnly ? 0.0 : R * c;
+		const double y = rise * t;
+		const double z = axisOnly ? 0.0 : R * s;
+
+		for (unsigned k = 0; k < 3; k++) {
+			xyz[3 * i + k] = (float) (x * matrix[0][k] + y * matrix[1][k] +
+				z * matrix[2][k] + matrix[3][k]);
+		}
+
+		const double nc = c * cs - s * ss;
+		s = s * cs + c * ss;
+		c = nc;
+	}
+}
+
+/////////////////////////////////////////////////////////////
+// Ray distance
+/////////////////////////////////////////////////////////////
+
+// Spacing of the first pass over angles. Well below the distance
+// between the minima of the ray distance, which are a turn apart.
+static const double kRaySearchStep = 0.1;
+
+struct helixRay
+{
+	double			o[3];
+	double			d[3];			// Unit length
+	double			R;
+	double			h;
+};
+
+static double raySquaredDistance(const helixRay& ray, double t, double* along)
+{
+	const double p[3] = {
+		ray.R * cos(t) - ray.o[0],
+		ray.h * t - ray.o[1],
+		ray.R * sin(t) - ray.o[2]
+	};
+	double s = p[0] * ray.d[0] + p[1] * ray.d[1] + p[2] * ray.d[2];
+	if (s < 0.0)
+		s = 0.0;					// Behind the ray's origin
+	if (along)
+		*along = s;
+
+	double d2 = 0.0;
+	for (unsigned k = 0; k < 3; k++) {
+		double e = p[k] - s * ray.d[k];
+		d2 += e * e;
+	}
+	return d2;
+}
+
+static double goldenSection(const helixRay& ray, double lo, double hi)
+{
+	const double ratio = 0.61803398874989485;
+	double x1 = hi - ratio * (hi - lo);
+	double x2 = lo + ratio * (hi - lo);
+	double f1 = raySquaredDistance(ray, x1, NULL);
+	double f2 = raySquaredDistance(ray, x2, NULL);
+
+	for (unsigned i = 0; i < 40 && hi - lo > 1.0e-9; i++) {
+		if (f1 < f2) {
+			hi = x2; x2 = x1; f2 = f1;
+			x1 = hi - ratio * (hi - lo);
+			f1 = raySquaredDistance(ray, x1, NULL);
+		}
+		else {
+			lo = x1; x1 = x2; f1 = f2;
+			x2 = lo + ratio * (hi - lo);
+			f2 = raySquaredDistance(ray, x2, NULL);
+		}
+	}
+	return 0.5 * (lo + hi);
+}
+
+bool helixRayDistance(double cvRadius, double rise, unsigned numCVs,
+	const double origin[3], const double direction[3], double tolerance,
+	double& distance, double& angle, double& rayParam)
+	//
+	// Description
+	//     The curve stays within R of the Y axis, so the ray can only
+	//     come within tolerance of it while inside the cylinder of
+	//     radius R + tolerance. Solving that quadratic gives the ray's
+	//     span inside the cylinder, the span's heights give the range
+	//     of angles worth searching (all of them for a ray along the
+	//     axis or a flat helix), and the closest angle in that range
+	//     is found by a coarse pass whose local minima are refined by
+	//     golden section search.
+	//
+{
+	if (numCVs < 4)
+		return false;
+
+	helixRay ray;
+	double length = sqrt(direction[0] * direction[0] +
+		direction[1] * direction[1] + direction[2] * direction[2]);
+	if (length == 0.0)
+		return false;
+	for (unsigned k = 0; k < 3; k++) {
+		ray.o[k] = origin[k];
+		ray.d[k] = direction[k] / length;
+	}
+	ray.R = helixCurveRadius(cvRadius);
+	ray.h = rise;
+
+	double first = 1.0;
+	double last = (double) (numCVs - 2);
+
+	const double reach = ray.R + tolerance;
+	const double a = ray.d[0] * ray.d[0] + ray.d[2] * ray.d[2];
+	const double b = 2.0 * (ray.o[0] * ray.d[0] + ray.o[2] * ray.d[2]);
+	const double c = ray.o[0] * ray.o[0] + ray.o[2] * ray.o[2] - reach * reach;
+
+	if (a < 1.0e-12) {
+		// Along the axis: inside the cylinder everywhere or nowhere.
+		if (c > 0.0)
+			return false;
+	}
+	else {
+		double disc = b * b - 4.0 * a * c;
+		if (disc < 0.0)
+			return false;
+		double root = sqrt(disc);
+		double s0 = (-b - root) / (2.0 * a);
+		double s1 = (-b + root) / (2.0 * a);
+		if (s1 < 0.0)
+			return false;
+		if (s0 < 0.0)
+			s0 = 0.0;
+
+		if (fabs(ray.h) > 1.0e-12) {
+			double t0 = (ray.o[1] + s0 * ray.d[1]) / ray.h;
+			double t1 = (ray.o[1] + s1 * ray.d[1]) / ray.h;
+			double slack = tolerance / fabs(ray.h);
+			double low = (t0 < t1 ? t0 : t1) - slack;
+			double high = (t0 > t1 ? t0 : t1) + slack;
+			if (low > first)
+				first = low;
+			if (high < last)
+				last = high;
+			if (first > last)
+				return false;
+		}
+	}
+
+	unsigned steps = (unsigned) ceil((last - first) / kRaySearchStep);
+	if (steps == 0)
+		steps = 1;
+	const double step = (last - first) / (double) steps;
+
+	// Refine every local minimum of the coarse pass; near grazing
+	// rays the deepest sample need not lie in the deepest basin.
+	double t = first;
+	double d2 = DBL_MAX;
+	double previous = DBL_MAX;
+	double current = raySquaredDistance(ray, first, NULL);
+	for (unsigned i = 0; i <= steps; i++) {
+		const double ti = first + step * (double) i;
+		const double next = (i < steps) ?
+			raySquaredDistance(ray, ti + step, NULL) : DBL_MAX;
+
+		if (current <= previous && current <= next) {
+			double lo = (i > 0) ? ti - step : first;
+			double hi = (i < steps) ? ti + step : last;
+			double tMin = goldenSection(ray, lo, hi);
+			double dMin = raySquaredDistance(ray, tMin, NULL);
+			if (current < dMin) {
+				dMin = current;
+				tMin = ti;
+			}
+			if (dMin < d2) {
+				d2 = dMin;
+				t = tMin;
+			}
+		}
+
+		previous = current;
+		current = next;
+	}
+
+	if (d2 > tolerance * tolerance)
+		return false;
+
+	distance = sqrt(d2);
+	angle = t;
+	raySquaredDistance(ray, t, &rayParam);
+	return true;
+}
+
+/////////////////////////////////////////////////////////////
+// Tapered and variable pitch helices
+/////////////////////////////////////////////////////////////
+
+void helixBakePitchTable(const double* positions, const double* values,
+	unsigned count, float* table)
+{
+	unsigned entry = 0;
+	for (unsigned j = 0; j < kPitchTableSize; j++) {
+		const double u = (double) j / (double) (kPitchTableSize - 1);
+		double value;
+
+		if (count == 0)
+			value = 1.0;
+		else if (u <= positions[0])
+			value = values[0];
+		else if (u >= positions[count - 1])
+			value = values[count - 1];
+		else {
+			while (entry + 1 < count && positions[entry + 1] < u)
+				entry++;
+			const double span = positions[entry + 1] - positions[entry];
+			const double f = (span > 0.0) ? (u - positions[entry]) / span : 0.0;
+			value = values[entry] + f * (values[entry + 1] - values[entry]);
+		}
+		table[j] = (float) value;
+	}
+}
+
+static inline double pitchTableAt(const float* table, double u)
+{
+	const double x = u * (double) (kPitchTableSize - 1);
+	unsigned j = (unsigned) x;
+	if (j >= kPitchTableSize - 1)
+		return table[kPitchTableSize - 1];
+	const double f = x - (double) j;
+	return table[j] + f * (table[j + 1] - table[j]);
+}
+
+void helixProfileCVRange(double radius, double endRadius, double rise,
+	const float* pitchTable, unsigned numCVs, unsigned first, unsigned end,
+	double& height, double (*cvs)[4])
+	//
+	// Description
+	//     The height of each CV adds the rise of the step before it,
+	//     taken at the middle of that step, so the whole helix is one
+	//     pass with one table lookup per CV.
+	//
+{
+	const double last = (numCVs > 1) ? (double) (numCVs - 1) : 1.0;
+
+	for (unsigned i = first; i < end; i++) {
+		if (i > 0) {
+			height += pitchTable ?
+				rise * pitchTableAt(pitchTable, ((double) i - 0.5) / last) : rise;
+		}
+		const double r = radius + (endRadius - radius) * ((double) i / last);
+		cvs[i][0] = r * cos((double) i);
+		cvs[i][1] = pitchTable ? height : rise * (double) i;
+		cvs[i][2] = r * sin((double) i);
+		cvs[i][3] = 1.0;
+	}
+}
+
+void helixProfileCVs(double radius, double endRadius, double rise,
+	const float* pitchTable, unsigned numCVs, double (*cvs)[4])
+{
+	double height = 0.0;
+	helixProfileCVRange(radius, endRadius, rise, pitchTable, numCVs,
+		0, numCVs, height, cvs);
+}
+
+unsigned helixCurveKnotCount(unsigned numCVs)
+{
+	// spans + 2 * degree - 1, with numCVs - degree spans.
+	return numCVs + 2;
+}
+
+void helixCurve(double radius, double endRadius, double rise,
+	const float* pitchTable, unsigned numCVs, double (*cvs)[4],
+	double* knots)
+{
+	if (cvs)
+		helixProfileCVs(radius, endRadius, rise, pitchTable, numCVs, cvs);
+	if (knots) {
+		const unsigned count = helixCurveKnotCount(numCVs);
+		for (unsigned i = 0; i < count; i++)
+			knots[i] = (double) i;
+	}
+}
+
+void helixStrandCVs(double radius, double endRadius, double rise,
+	const float* pitchTable, unsigned numCVs, unsigned strands,
+	double (*cvs)[4])
+	//
+	// Description
+	//     cos(i + phase) = cos i cos phase - sin i sin phase, and the
+	//     same for sin, so each further strand costs two multiply-adds
+	//     per coordinate.
+	//
+{
+	helixProfileCVs(radius, endRadius, rise, pitchTable, numCVs, cvs);
+
+	for (unsigned k = 1; k < strands; k++) {
+		const double phase = 2.0 * PI * (double) k / (double) strands;
+		const double c = cos(phase);
+		const double s = sin(phase);
+		double (*strand)[4] = cvs + (size_t) k * numCVs;
+
+		for (unsigned i = 0; i < numCVs; i++) {
+			strand[i][0] = cvs[i][0] * c - cvs[i][2] * s;
+			strand[i][1] = cvs[i][1];
+			strand[i][2] = cvs[i][0] * s + cvs[i][2] * c;
+			strand[i][3] = 1.0;
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////
+// Vectors
+/////////////////////////////////////////////////////////////
+
+static inline double dot3(const double* a, const double* b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static void normalize3(double* v)
+{
+	double length = sqrt(dot3(v, v));
+	if (length > 0.0) {
+		v[0] /= length;
+		v[1] /= length;
+		v[2] /= length;
+	}
+}
+
+static inline void cross3(const double* a, const double* b, double* out)
+{
+	out[0] = a[1] * b[2] - a[2] * b[1];
+	out[1] = a[2] * b[0] - a[0] * b[2];
+	out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+/////////////////////////////////////////////////////////////
+// Closest points
+/////////////////////////////////////////////////////////////
+
+// Queries per thread pool task.
+static const unsigned kClosestPerTask = 8192;
+
+// Most Newton steps on the ideal helix, then on the curve, and the
+// step at which they stop early.
+static const unsigned kHelixNewtonSteps = 8;
+static const unsigned kCurveNewtonSteps = 8;
+static const double kNewtonTolerance = 1.0e-13;
+
+// Furthest the curve strays from the ideal helix, over the CV radius.
+static const double kCurveStray = 0.01;
+
+static const double kCos1 = 0.54030230586813977;	// cos 1
+static const double kSin1 = 0.84147098480789651;	// sin 1
+
+static void helixCurveAt(double cvRadius, double rise, unsigned numCVs,
+	double t, double* point, double* d1, double* d2)
+	//
+	// Description
+	//     Point and derivatives of the uniform cubic B-spline through
+	//     the tool's CVs at curve parameter t, from 2 to numCVs - 1.
+	//     Span s, from t = s + 2 to s + 3, uses CVs s to s + 3, whose
+	//     angles step by one radian from the first, so one cos/sin
+	//     pair serves all four.
+	//
+{
+	int span = (int) floor(t - 2.0);
+	if (span < 0)
+		span = 0;
+	if (span > (int) numCVs - 4)
+		span = (int) numCVs - 4;
+	const double u = t - 2.0 - (double) span;
+	const double u2 = u * u;
+	const double u3 = u2 * u;
+
+	const double b[4] = {
+		(1.0 - u) * (1.0 - u) * (1.0 - u) / 6.0,
+		(3.0 * u3 - 6.0 * u2 + 4.0) / 6.0,
+		(-3.0 * u3 + 3.0 * u2 + 3.0 * u + 1.0) / 6.0,
+		u3 / 6.0 };
+	const double db[4] = {
+		-0.5 * (1.0 - u) * (1.0 - u),
+		1.5 * u2 - 2.0 * u,
+		-1.5 * u2 + u + 0.5,
+		0.5 * u2 };
+	const double ddb[4] = { 1.0 - u, 3.0 * u - 2.0, -3.0 * u + 1.0, u };
+
+	for (unsigned k = 0; k < 3; k++)
+		point[k] = d1[k] = d2[k] = 0.0;
+
+	double c = cos((double) span);
+	double sn = sin((double) span);
+	for (unsigned j = 0; j < 4; j++) {
+		const double cv[3] = { cvRadius * c, rise * (double) (span + (int) j), cvRadius * sn };
+		for (unsigned k = 0; k < 3; k++) {
+			point[k] += b[j] * cv[k];
+			d1[k] += db[j] * cv[k];
+			d2[k] += ddb[j] * cv[k];
+		}
+		const double next = c * kCos1 - sn * kSin1;
+		sn = sn * kCos1 + c * kSin1;
+		c = next;
+	}
+}
+
+static double refineOnCurve(double cvRadius, double rise, unsigned numCVs,
+	const double* q, double t, double* point)
+	//
+	// Description
+	//     Newton steps on (C(t) - q) . C'(t) = 0 from t; returns the
+	//     final parameter, with the curve point there.
+	//
+{
+	const double tMin = 2.0;
+	const double tMax = (double) numCVs - 1.0;
+	double d1[3], d2[3];
+
+	for (unsigned n = 0; n < kCurveNewtonSteps; n++) {
+		helixCurveAt(cvRadius, rise, numCVs, t, point, d1, d2);
+		double h = 0.0, dh = 0.0;
+		for (unsigned k = 0; k < 3; k++) {
+			const double e = point[k] - q[k];
+			h += e * d1[k];
+			dh += d1[k] * d1[k] + e * d2[k];
+		}
+		if (dh <= 0.0)
+			break;
+		double step = -h / dh;
+		if (step > 0.5) step = 0.5;
+		if (step < -0.5) step = -0.5;
+		t += step;
+		if (t < tMin) t = tMin;
+		if (t > tMax) t = tMax;
+		if (fabs(step) < kNewtonTolerance)
+			break;
+	}
+	helixCurveAt(cvRadius, rise, numCVs, t, point, d1, d2);
+	return t;
+}
+
+static double idealAngle(double R, double rise, double rho, double phi,
+	double y, double first, double last, double angle)
+	//
+	// Description
+	//     On the ideal helix, g(angle) = R rho sin(angle - phi) +
+	//     rise^2 angle - rise y is zero where the distance to the
+	//     query is stationary, once per coil. Newton steps on g from
+	//     angle, kept inside the helix.
+	//
+{
+	for (unsigned n = 0; n < kHelixNewtonSteps; n++) {
+		const double g = R * rho * sin(angle - phi) + rise * rise * angle - rise * y;
+		const double dg = R * rho * cos(angle - phi) + rise * rise;
+		double step = (dg > 0.0) ? -g / dg : (g > 0.0 ? -0.5 : 0.5);
+		if (step > 0.5) step = 0.5;
+		if (step < -0.5) step = -0.5;
+		angle += step;
+		if (angle < first) angle = first;
+		if (angle > last) angle = last;
+		if (fabs(step) < kNewtonTolerance)
+			break;
+	}
+	return angle;
+}
+
+struct closestState
+{
+	double			bestIdeal;		// Nearest distance on the ideal helix
+	double			bestDistance2;	// Nearest squared distance on the curve
+	double			param;
+	double			point[3];
+};
+
+static void tryCandidate(double cvRadius, double rise, unsigned numCVs,
+	const double* q, double rho, double phi, double angle, closestState& state)
+	//
+	// Description
+	//     Finds the stationary point on the ideal helix near angle,
+	//     and refines it on the curve if it is close enough to the
+	//     best so far to possibly win. The curve strays from the
+	//     ideal helix by under 1% of the CV radius.
+	//
+{
+	const double R = helixCurveRadius(cvRadius);
+	const double first = 1.0;
+	const double last = (double) numCVs - 2.0;
+	angle = idealAngle(R, rise, rho, phi, q[1], first, last, angle);
+
+	const double dx = R * cos(angle) - q[0];
+	const double dy = rise * angle - q[1];
+	const double dz = R * sin(angle) - q[2];
+	const double ideal = sqrt(dx * dx + dy * dy + dz * dz);
+	if (ideal > state.bestIdeal + kCurveStray * cvRadius)
+		return;
+	if (ideal < state.bestIdeal)
+		state.bestIdeal = ideal;
+
+	double point[3];
+	const double t = refineOnCurve(cvRadius, rise, numCVs, q, angle + 1.0, point);
+	double distance2 = 0.0;
+	for (unsigned k = 0; k < 3; k++)
+		distance2 += (point[k] - q[k]) * (point[k] - q[k]);
+	if (distance2 < state.bestDistance2) {
+		state.bestDistance2 = distance2;
+		state.param = t;
+		for (unsigned k = 0; k < 3; k++)
+			state.point[k] = point[k];
+	}
+}
+
+static void closestPoint(double cvRadius, double rise, unsigned numCVs,
+	const double* q, double* closest, double& param, double& distance)
+	//
+	// Description
+	//     Candidates are the ends of the helix and the stationary
+	//     point of each coil whose height could bring it within the
+	//     curve's stray of the coil level with the query. Those are
+	//     tried from the query's own coil outwards, so the best ideal
+	//     distance is known early and most are rejected before they
+	//     are refined. For a flat helix every coil is a candidate.
+	//
+{
+	const double first = 1.0;
+	const double last = (double) numCVs - 2.0;
+	const double rho = sqrt(q[0] * q[0] + q[2] * q[2]);
+	const double phi = atan2(q[2], q[0]);
+
+	// Coils whose stationary point lies inside the helix.
+	const double kMin = ceil((first - phi) / (2.0 * PI));
+	const double kMax = floor((last - phi) / (2.0 * PI));
+
+	double kCentre = (rise != 0.0)
+		? floor((q[1] / rise - phi) / (2.0 * PI) + 0.5)
+		: floor((0.5 * (first + last) - phi) / (2.0 * PI) + 0.5);
+	kCentre = std::min(std::max(kCentre, kMin), kMax);
+
+	const double coilRise = fabs(2.0 * PI * rise);
+	const double spread = (coilRise > 0.0)
+		? 1.0 + ceil(2.0 * kCurveStray * cvRadius / coilRise)
+		: kMax - kMin;
+
+	closestState state;
+	state.bestIdeal = DBL_MAX;
+	state.bestDistance2 = DBL_MAX;
+	state.param = 2.0;
+
+	if (kMin <= kMax) {
+		tryCandidate(cvRadius, rise, numCVs, q, rho, phi, phi + 2.0 * PI * kCentre, state);
+		for (double d = 1.0; d <= spread; d += 1.0) {
+			if (kCentre - d < kMin && kCentre + d > kMax)
+				break;
+			if (kCentre - d >= kMin)
+				tryCandidate(cvRadius, rise, numCVs, q, rho, phi, phi + 2.0 * PI * (kCentre - d), state);
+			if (kCentre + d <= kMax)
+				tryCandidate(cvRadius, rise, numCVs, q, rho, phi, phi + 2.0 * PI * (kCentre + d), state);
+		}
+	}
+	tryCandidate(cvRadius, rise, numCVs, q, rho, phi, first, state);
+	tryCandidate(cvRadius, rise, numCVs, q, rho, phi, last, state);
+
+	param = state.param;
+	distance = sqrt(state.bestDistance2);
+	for (unsigned k = 0; k < 3; k++)
+		closest[k] = state.point[k];
+}
+
+struct closestTask
+{
+	double			cvRadius;
+	double			rise;
+	unsigned		numCVs;
+	const double	(*points)[3];
+	unsigned		first;
+	unsigned		end;
+	double			(*closest)[3];
+	double*			params;
+	double*			distances;
+};
+
+static MThreadRetVal closestTaskFunc(void* data)
+{
+	closestTask* task = (closestTask*) data;
+	for (unsigned i = task->first; i < task->end; i++) {
+		closestPoint(task->cvRadius, task->rise, task->numCVs, task->points[i],
+			task->closest[i], task->params[i], task->distances[i]);
+	}
+	return 0;
+}
+
+static void closestDecompose(void* data, MThreadRootTask* root)
+{
+	std::vector<closestTask>* tasks = (std::vector<closestTask>*) data;
+	for (size_t i = 0; i < tasks->size(); i++)
+		MThreadPool::createTask(closestTaskFunc, (void*) &(*tasks)[i], root);
+	MThreadPool::executeAndJoin(root);
+}
+
+void helixClosestPoints(double cvRadius, double rise, unsigned numCVs,
+	const double (*points)[3], unsigned count,
+	double (*closest)[3], double* params, double* distances)
+	//
+	// Description
+	//     Queries are spread over threads, not SIMD lanes. Each one
+	//     tries its own number of coils and Newton steps, stopping
+	//     early, so lanes would sit idle waiting on the slowest; and
+	//     most of the time goes in cos and sin, which SSE2 has no
+	//     instructions for.
+	//
+{
+	std::vector<closestTask> tasks;
+	for (unsigned first = 0; first < count; first += kClosestPerTask) {
+		closestTask task;
+		task.cvRadius = cvRadius;
+		task.rise = rise;
+		task.numCVs = numCVs;
+		task.points = points;
+		task.first = first;
+		task.end = (count - first < kClosestPerTask) ? count : first + kClosestPerTask;
+		task.closest = closest;
+		task.params = params;
+		task.distances = distances;
+		tasks.push_back(task);
+	}
+
+	if (tasks.size() < 2 || !MThreadPool::newParallelRegion(closestDecompose, (void*) &tasks)) {
+		for (size_t i = 0; i < tasks.size(); i++)
+			closestTaskFunc(&tasks[i]);
+	}
+}
+
+/////////////////////////////////////////////////////////////
+// Arc length
+/////////////////////////////////////////////////////////////
+
+// Resampled points per thread pool task.
+static const unsigned kResamplePerTask = 8192;
+
+// Intervals of a span in the arc length table.
+static const unsigned kArcTableSize = 64;
+
+// Most Newton steps to invert the arc length within a span.
+static const unsigned kArcNewtonSteps = 8;
+
+// Eight point Gauss-Legendre rule on [-1, 1].
+static const double kGaussNodes[4] = {
+	0.1834346424956498, 0.5255324099163290, 0.7966664774136267, 0.9602898564975363 };
+static const double kGaussWeights[4] = {
+	0.3626837833783620, 0.3137066458778873, 0.2223810344533745, 0.1012285362903763 };
+
+static double spanSpeed(double cvRadius, double rise, double u)
+	//
+	// Description
+	//     Speed of the curve a fraction u along a span. Every span is
+	//     the first one turned about Y and raised, so it is the same
+	//     for all of them.
+	//
+{
+	double point[3], d1[3], d2[3];
+	helixCurveAt(cvRadius, rise, 4, 2.0 + u, point, d1, d2);
+	return sqrt(d1[0] * d1[0] + d1[1] * d1[1] + d1[2] * d1[2]);
+}
+
+static double spanLengthTo(double cvRadius, double rise, double u)
+	//
+	// Description
+	//     Arc length from the start of a span to u along it. The speed
+	//     is smooth and varies by under a percent, so one Gauss rule
+	//     is exact to rounding.
+	//
+{
+	double length = 0.0;
+	for (unsigned i = 0; i < 4; i++) {
+		const double offset = 0.5 * u * kGaussNodes[i];
+		length += kGaussWeights[i] * (spanSpeed(cvRadius, rise, 0.5 * u - offset) +
+			spanSpeed(cvRadius, rise, 0.5 * u + offset));
+	}
+	return 0.5 * u * length;
+}
+
+double helixArcLength(double cvRadius, double rise, unsigned numCVs)
+{
+	if (numCVs < 4)
+		return 0.0;
+	return (double) (numCVs - 3) * spanLengthTo(cvRadius, rise, 1.0);
+}
+
+// The length along a span at evenly spaced fractions of it, with the
+// speed there: a cubic Hermite through them inverts the length to a
+// fraction without integrating again for every point.
+//
+struct helixArcTable
+{
+	double			spanLength;
+	double			length[kArcTableSize + 1];
+	double			speed[kArcTableSize + 1];
+
+	void			build(double cvRadius, double rise);
+	double			fraction(double along) const;
+};
+
+void helixArcTable::build(double cvRadius, double rise)
+{
+	const double h = 1.0 / (double) kArcTableSize;
+	length[0] = 0.0;
+	speed[0] = spanSpeed(cvRadius, rise, 0.0);
+	for (unsigned j = 1; j <= kArcTableSize; j++) {
+		const double u = h * (double) j;
+		double interval = 0.0;
+		for (unsigned i = 0; i < 4; i++) {
+			const double offset = 0.5 * h * kGaussNodes[i];
+			interval += kGaussWeights[i] * (spanSpeed(cvRadius, rise, u - 0.5 * h - offset) +
+				spanSpeed(cvRadius, rise, u - 0.5 * h + offset));
+		}
+		length[j] = length[j - 1] + 0.5 * h * interval;
+		speed[j] = spanSpeed(cvRadius, rise, u);
+	}
+	spanLength = length[kArcTableSize];
+}
+
+double helixArcTable::fraction(double along) const
+	//
+	// Description
+	//     The fraction of a span at which the length along it is
+	//     along. The speed barely varies, so the entry is found from
+	//     an even guess and a step or two either way.
+	//
+{
+	if (!(spanLength > 0.0))
+		return 0.0;
+
+	int j = (int) (along / spanLength * (double) kArcTableSize);
+	if (j < 0) j = 0;
+	if (j > (int) kArcTableSize - 1) j = (int) kArcTableSize - 1;
+	while (j > 0 && length[j] > along)
+		j--;
+	while (j < (int) kArcTableSize - 1 && length[j + 1] < along)
+		j++;
+
+	const double h = length[j + 1] - length[j];
+	const double s = (h > 0.0) ? (along - length[j]) / h : 0.0;
+	const double s2 = s * s;
+	const double s3 = s2 * s;
+	const double step = 1.0 / (double) kArcTableSize;
+
+	// du/ds is one over the speed; the tangents are scaled to the
+	// interval's length.
+	return (2.0 * s3 - 3.0 * s2 + 1.0) * step * (double) j +
+		(s3 - 2.0 * s2 + s) * h / speed[j] +
+		(-2.0 * s3 + 3.0 * s2) * step * (double) (j + 1) +
+		(s3 - s2) * h / speed[j + 1];
+}
+
+struct resampleTask
+{
+	const helixArcTable* table;	// Or NULL to integrate for every point
+	double			spanLength;
+	double			cvRadius;
+	double			rise;
+	unsigned		numCVs;
+	double			spacing;
+	unsigned		first;
+	unsigned		end;
+	double			(*points)[3];
+	double			(*rotations)[3];	// Or NULL
+	double*			params;
+};
+
+static void eulerFromAxes(const double* x, const double* y, const double* z,
+	double* rotation)
+	//
+	// Description
+	//     Euler angles, in XYZ order, of the frame with axes x, y and z.
+	//     With row vectors, the axes are the rows of Rx Ry Rz.
+	//
+{
+	rotation[0] = atan2(y[2], z[2]);
+	rotation[1] = atan2(-x[2], sqrt(x[0] * x[0] + x[1] * x[1]));
+	rotation[2] = atan2(x[1], x[0]);
+}
+
+static void axesFromEuler(const double* rotation, double axes[3][3])
+	//
+	// Description
+	//     The inverse of eulerFromAxes: the rows of Rx Ry Rz.
+	//
+{
+	const double cx = cos(rotation[0]), sx = sin(rotation[0]);
+	const double cy = cos(rotation[1]), sy = sin(rotation[1]);
+	const double cz = cos(rotation[2]), sz = sin(rotation[2]);
+
+	axes[0][0] = cy * cz;
+	axes[0][1] = cy * sz;
+	axes[0][2] = -sy;
+	axes[1][0] = sx * sy * cz - cx * sz;
+	axes[1][1] = sx * sy * sz + cx * cz;
+	axes[1][2] = sx * cy;
+	axes[2][0] = cx * sy * cz + sx * sz;
+	axes[2][1] = cx * sy * sz - sx * cz;
+	axes[2][2] = cx * cy;
+}
+
+static void instanceRotation(const double* point, const double* tangent,
+	double* rotation)
+	//
+	// Description
+	//     Euler angles, in XYZ order, of the frame whose X axis runs
+	//     along the curve and whose Z axis points out from the helix's
+	//     axis. With row vectors, the frame's axes are the rows of
+	//     Rx Ry Rz.
+	//
+{
+	double x[3] = { tangent[0], tangent[1], tangent[2] };
+	normalize3(x);
+
+	double z[3] = { point[0], 0.0, point[2] };
+	if (dot3(z, z) == 0.0)
+		z[2] = 1.0;
+	const double along = dot3(z, x);
+	for (unsigned k = 0; k < 3; k++)
+		z[k] -= along * x[k];
+	normalize3(z);
+
+	double y[3];
+	cross3(z, x, y);
+
+	eulerFromAxes(x, y, z, rotation);
+}
+
+static MThreadRetVal resampleTaskFunc(void* data)
+	//
+	// Description
+	//     Point i is spacing * i along the curve: whole spans first,
+	//     then the fraction of the span for the rest. Without a table
+	//     that is Newton steps on the integrated length, to rounding;
+	//     the table's cubic is good to about 1e-9 of a span.
+	//
+{
+	resampleTask* task = (resampleTask*) data;
+	const unsigned spans = task->numCVs - 3;
+
+	for (unsigned i = task->first; i < task->end; i++) {
+		const double length = task->spacing * (double) i;
+		double whole = floor(length / task->spanLength);
+		if (whole > (double) (spans - 1))
+			whole = (double) (spans - 1);
+		if (!(whole >= 0.0))
+			whole = 0.0;
+		const double rest = length - whole * task->spanLength;
+
+		double u;
+		if (task->table) {
+			u = task->table->fraction(rest);
+			if (u > 1.0)
+				u = 1.0;
+		} else {
+			u = rest / task->spanLength;
+			for (unsigned n = 0; n < kArcNewtonSteps; n++) {
+				const double step = (spanLengthTo(task->cvRadius, task->rise, u) - rest) /
+					spanSpeed(task->cvRadius, task->rise, u);
+				u -= step;
+				if (u < 0.0) u = 0.0;
+				if (u > 1.0) u = 1.0;
+				if (fabs(step) < kNewtonTolerance)
+					break;
+			}
+		}
+
+		double d1[3], d2[3];
+		task->params[i] = whole + 2.0 + u;
+		helixCurveAt(task->cvRadius, task->rise, task->numCVs, task->params[i],
+			task->points[i], d1, d2);
+		if (task->rotations)
+			instanceRotation(task->points[i], d1, task->rotations[i]);
+	}
+	return 0;
+}
+
+static void resampleDecompose(void* data, MThreadRootTask* root)
+{
+	std::vector<resampleTask>* tasks = (std::vector<resampleTask>*) data;
+	for (size_t i = 0; i < tasks->size(); i++)
+		MThreadPool::createTask(resampleTaskFunc, (void*) &(*tasks)[i], root);
+	MThreadPool::executeAndJoin(root);
+}
+
+static void resample(double cvRadius, double rise, unsigned numCVs,
+	unsigned count, bool exact, double (*points)[3], double (*rotations)[3],
+	double* params)
+	//
+	// Description
+	//     Exact integrates the length for every point; otherwise one
+	//     table, built up front, is shared by all of them.
+	//
+{
+	if (numCVs < 4 || count == 0)
+		return;
+
+	helixArcTable table;
+	double spanLength;
+	if (exact) {
+		spanLength = spanLengthTo(cvRadius, rise, 1.0);
+	} else {
+		table.build(cvRadius, rise);
+		spanLength = table.spanLength;
+	}
+	const double total = (double) (numCVs - 3) * spanLength;
+
+	std::vector<resampleTask> tasks;
+	for (unsigned first = 0; first < count; first += kResamplePerTask) {
+		resampleTask task;
+		task.table = exact ? NULL : &table;
+		task.spanLength = spanLength;
+		task.cvRadius = cvRadius;
+		task.rise = rise;
+		task.numCVs = numCVs;
+		task.spacing = (count > 1) ? total / (double) (count - 1) : 0.0;
+		task.first = first;
+		task.end = (count - first < kResamplePerTask) ? count : first + kResamplePerTask;
+		task.points = points;
+		task.rotations = rotations;
+		task.params = params;
+		tasks.push_back(task);
+	}
+
+	if (tasks.size() < 2 || !MThreadPool::newParallelRegion(resampleDecompose, (void*) &tasks)) {
+		for (size_t i = 0; i < tasks.size(); i++)
+			resampleTaskFunc(&tasks[i]);
+	}
+}
+
+void helixResample(double cvRadius, double rise, unsigned numCVs,
+	unsigned count, double (*points)[3], double* params)
+{
+	resample(cvRadius, rise, numCVs, count, true, points, NULL, params);
+}
+
+void helixInstanceFrames(double cvRadius, double rise, unsigned numCVs,
+	unsigned count, double (*positions)[3], double (*rotations)[3],
+	double* params)
+{
+	resample(cvRadius, rise, numCVs, count, false, positions, rotations, params);
+}
+
+void helixJointFrames(double cvRadius, double rise, unsigned numCVs,
+	unsigned count, double (*translates)[3], double (*orients)[3])
+	//
+	// Description
+	//     Starts from the frames for instancing, in the helix's space,
+	//     and works back from the end of the chain, taking each frame
+	//     into its parent's while the parent's is still unchanged.
+	//
+{
+	if (numCVs < 4 || count == 0)
+		return;
+
+	std::vector<double> params(count);
+	resample(cvRadius, rise, numCVs, count, false, translates, orients, &params[0]);
+
+	double child[3][3], parent[3][3];
+	axesFromEuler(orients[count - 1], child);
+	for (unsigned i = count - 1; i > 0; i--) {
+		axesFromEuler(orients[i - 1], parent);
+
+		double step[3];
+		for (unsigned k = 0; k < 3; k++)
+			step[k] = translates[i][k] - translates[i - 1][k];
+		double local[3][3];
+		for (unsigned a = 0; a < 3; a++) {
+			translates[i][a] = dot3(step, parent[a]);
+			for (unsigned b = 0; b < 3; b++)
+				local[a][b] = dot3(child[a], parent[b]);
+		}
+		eulerFromAxes(local[0], local[1], local[2], orients[i]);
+
+		for (unsigned a = 0; a < 3; a++)
+			for (unsigned b = 0; b < 3; b++)
+				child[a][b] = parent[a][b];
+	}
+}
+
+/////////////////////////////////////////////////////////////
+// Fitting
+/////////////////////////////////////////////////////////////
+
+// Curves per thread pool task.
+static const unsigned kFitCurvesPerTask = 1024;
+
+static bool solve3(double m[3][3], double b[3], double x[3])
+	//
+	// Description
+	//     Cramer's rule; the systems here are small and well scaled.
+	//
+{
+	const double det =
+		m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+		m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+		m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+	if (fabs(det) < 1.0e-300)
+		return false;
+
+	for (unsigned c = 0; c < 3; c++) {
+		double t[3][3];
+		for (unsigned r = 0; r < 3; r++) {
+			for (unsigned k = 0; k < 3; k++)
+				t[r][k] = (k == c) ? b[r] : m[r][k];
+		}
+		x[c] = (t[0][0] * (t[1][1] * t[2][2] - t[1][2] * t[2][1]) -
+			t[0][1] * (t[1][0] * t[2][2] - t[1][2] * t[2][0]) +
+			t[0][2] * (t[1][0] * t[2][1] - t[1][1] * t[2][0])) / det;
+	}
+	return true;
+}
+
+void helixFitCVs(const double (*cvs)[3], unsigned count, helixFit& fit)
+{
+	fit.fitted = false;
+	fit.residual = DBL_MAX;
+	if (count < 5)
+		return;
+
+	// Axis. Second differences of a helix point from each CV towards
+	// the axis, so their successive cross products all lie along it.
+	double axis[3] = { 0.0, 0.0, 0.0 };
+	double previous[3];
+	for (unsigned i = 1; i + 1 < count; i++) {
+		double d[3];
+		for (unsigned k = 0; k < 3; k++)
+			d[k] = cvs[i + 1][k] - 2.0 * cvs[i][k] + cvs[i - 1][k];
+		if (i > 1) {
+			double c[3];
+			cross3(previous, d, c);
+			for (unsigned k = 0; k < 3; k++)
+				axis[k] += c[k];
+		}
+		for (unsigned k = 0; k < 3; k++)
+			previous[k] = d[k];
+	}
+	if (dot3(axis, axis) <= 0.0)
+		return;
+	normalize3(axis);
+
+	// Plane across the axis: u, and w = u x axis.
+	unsigned least = 0;
+	for (unsigned k = 1; k < 3; k++) {
+		if (fabs(axis[k]) < fabs(axis[least]))
+			least = k;
+	}
+	double u[3] = { 0.0, 0.0, 0.0 };
+	u[least] = 1.0;
+	const double along = dot3(u, axis);
+	for (unsigned k = 0; k < 3; k++)
+		u[k] -= along * axis[k];
+	normalize3(u);
+	double w[3];
+	cross3(u, axis, w);
+
+	// Kasa fit of x^2 + y^2 + D x + E y + F = 0, about the mean so
+	// that the normal equations stay well conditioned.
+	double mean[2] = { 0.0, 0.0 };
+	for (unsigned i = 0; i < count; i++) {
+		mean[0] += dot3(cvs[i], u);
+		mean[1] += dot3(cvs[i], w);
+	}
+	mean[0] /= count;
+	mean[1] /= count;
+
+	double m[3][3] = { { 0.0 } };
+	double b[3] = { 0.0, 0.0, 0.0 };
+	for (unsigned i = 0; i < count; i++) {
+		const double x = dot3(cvs[i], u) - mean[0];
+		const double y = dot3(cvs[i], w) - mean[1];
+		const double row[3] = { x, y, 1.0 };
+		const double rhs = -(x * x + y * y);
+		for (unsigned r = 0; r < 3; r++) {
+			for (unsigned k = 0; k < 3; k++)
+				m[r][k] += row[r] * row[k];
+			b[r] += row[r] * rhs;
+		}
+	}
+	double def[3];
+	if (!solve3(m, b, def))
+		return;
+	const double cx = -0.5 * def[0];
+	const double cy = -0.5 * def[1];
+	const double radius2 = cx * cx + cy * cy - def[2];
+	if (!(radius2 > 0.0))
+		return;
+	const double radius = sqrt(radius2);
+
+	// Angle about the centre, unwrapped, against CV index; then
+	// height against angle.
+	double sumI = 0.0, sumT = 0.0, sumII = 0.0, sumIT = 0.0;
+	double sumH = 0.0, sumTT = 0.0, sumTH = 0.0;
+	double angle = 0.0;
+	for (unsigned i = 0; i < count; i++) {
+		const double x = dot3(cvs[i], u) - mean[0] - cx;
+		const double y = dot3(cvs[i], w) - mean[1] - cy;
+		const double a = atan2(y, x);
+		if (i == 0)
+			angle = a;
+		else {
+			double step = a - angle;
+			step -= 2.0 * PI * floor((step + PI) / (2.0 * PI));
+			angle += step;
+		}
+		const double h = dot3(cvs[i], axis);
+		sumI += i;
+		sumT += angle;
+		sumII += (double) i * i;
+		sumIT += i * angle;
+		sumH += h;
+		sumTT += angle * angle;
+		sumTH += angle * h;
+	}
+	const double n = (double) count;
+	double turn = (n * sumIT - sumI * sumT) / (n * sumII - sumI * sumI);
+	const double angleVar = n * sumTT - sumT * sumT;
+	if (!(fabs(turn) > 1.0e-6) || !(angleVar > 0.0))
+		return;
+	const double slope = (n * sumTH - sumT * sumH) / angleVar;
+	double height0 = (sumH - slope * sumT) / n;
+	double angle0 = (sumT - turn * sumI) / n;
+	double centre[2] = { mean[0] + cx, mean[1] + cy };
+
+	// Handedness does not depend on which way the axis points, so
+	// turn it to make the angle increase with the CV index. Angles,
+	// heights and w coordinates all change sign; the slope does not.
+	if (turn < 0.0) {
+		for (unsigned k = 0; k < 3; k++) {
+			axis[k] = -axis[k];
+			w[k] = -w[k];
+		}
+		turn = -turn;
+		angle0 = -angle0;
+		height0 = -height0;
+		centre[1] = -centre[1];
+	}
+
+	// The tool steps one radian per CV. Keep the curve through the
+	// CVs, whose radius is r (2 + cos step) / 3, where it is.
+	fit.radius = radius * (2.0 + cos(turn)) / (2.0 + cos(1.0));
+	fit.pitch = fabs(slope);
+	fit.upsideDown = slope < 0.0;
+	fit.numCVs = (unsigned) floor(turn * (n - 1.0) + 0.5) + 1;
+	fit.cvRadius = radius;
+	fit.turn = turn;
+	fit.rise = slope * turn;
+
+	// The tool's first CV lies along X at height 0.
+	double x[3], z[3], origin[3];
+	const double baseHeight = height0 + slope * angle0;
+	for (unsigned k = 0; k < 3; k++) {
+		x[k] = cos(angle0) * u[k] + sin(angle0) * w[k];
+		z[k] = -sin(angle0) * u[k] + cos(angle0) * w[k];
+		origin[k] = centre[0] * u[k] + centre[1] * w[k] + baseHeight * axis[k];
+	}
+
+	for (unsigned k = 0; k < 3; k++) {
+		fit.matrix[0][k] = x[k];
+		fit.matrix[1][k] = axis[k];
+		fit.matrix[2][k] = z[k];
+		fit.matrix[3][k] = origin[k];
+	}
+	fit.matrix[0][3] = fit.matrix[1][3] = fit.matrix[2][3] = 0.0;
+	fit.matrix[3][3] = 1.0;
+
+	// RMS distance to the CVs of the fitted curve, at its own step.
+	const double rise = fit.rise;
+	double sum2 = 0.0;
+	for (unsigned i = 0; i < count; i++) {
+		const double a = turn * (double) i;
+		for (unsigned k = 0; k < 3; k++) {
+			const double p = origin[k] + radius * (cos(a) * x[k] + sin(a) * z[k]) +
+				rise * (double) i * axis[k];
+			sum2 += (p - cvs[i][k]) * (p - cvs[i][k]);
+		}
+	}
+	fit.residual = sqrt(sum2 / n);
+
+	// A short or slowly turning curve can round to fewer CVs than
+	// the tool's helices have, which no helix can be built from.
+	fit.fitted = fit.numCVs >= 4;
+}
+
+struct fitTask
+{
+	const double	(*cvs)[3];
+	const unsigned*	offsets;
+	unsigned		first;
+	unsigned		end;
+	helixFit*		fits;
+};
+
+static MThreadRetVal fitTaskFunc(void* data)
+{
+	fitTask* task = (fitTask*) data;
+	for (unsigned c = task->first; c < task->end; c++) {
+		helixFitCVs(task->cvs + task->offsets[c],
+			task->offsets[c + 1] - task->offsets[c], task->fits[c]);
+	}
+	return 0;
+}
+
+static void fitDecompose(void* data, MThreadRootTask* root)
+{
+	std::vector<fitTask>* tasks = (std::vector<fitTask>*) data;
+	for (size_t i = 0; i < tasks->size(); i++)
+		MThreadPool::createTask(fitTaskFunc, (void*) &(*tasks)[i], root);
+	MThreadPool::executeAndJoin(root);
+}
+
+void helixFitBatch(const double (*cvs)[3], const unsigned* offsets,
+	unsigned curves, helixFit* fits)
+{
+	std::vector<fitTask> tasks;
+	for (unsigned first = 0; first < curves; first += kFitCurvesPerTask) {
+		fitTask task;
+		task.cvs = cvs;
+		task.offsets = offsets;
+		task.first = first;
+		task.end = (curves - first < kFitCurvesPerTask) ? curves : first + kFitCurvesPerTask;
+		task.fits = fits;
+		tasks.push_back(task);
+	}
+
+	if (tasks.size() < 2 || !MThreadPool::newParallelRegion(fitDecompose, (void*) &tasks)) {
+		for (size_t i = 0; i < tasks.size(); i++)
+			fitTaskFunc(&tasks[i]);
+	}
+}
+
+/////////////////////////////////////////////////////////////
+// Coils along a path
+/////////////////////////////////////////////////////////////
+
+void helixBuildPathFrames(const double (*points)[3], const double (*tangents)[3],
+	unsigned count, helixPathFrames& frames)
+{
+	frames.count = count;
+	frames.length.resize(count);
+	frames.point.resize(3 * (size_t) count);
+	frames.normal.resize(3 * (size_t) count);
+	frames.binormal.resize(3 * (size_t) count);
+	if (count == 0)
+		return;
+
+	// First normal: the axis least aligned with the tangent, made
+	// perpendicular to it.
+	double t[3] = { tangents[0][0], tangents[0][1], tangents[0][2] };
+	normalize3(t);
+	unsigned axis = 0;
+	for (unsigned k = 1; k < 3; k++) {
+		if (fabs(t[k]) < fabs(t[axis]))
+			axis = k;
+	}
+	double r[3] = { 0.0, 0.0, 0.0 };
+	r[axis] = 1.0;
+	double along = dot3(r, t);
+	for (unsigned k = 0; k < 3; k++)
+		r[k] -= along * t[k];
+	normalize3(r);
+
+	double total = 0.0;
+	for (unsigned i = 0; i < count; i++) {
+		if (i > 0) {
+			double v1[3], rL[3], tL[3], next[3];
+			for (unsigned k = 0; k < 3; k++) {
+				v1[k] = points[i][k] - points[i - 1][k];
+				next[k] = tangents[i][k];
+			}
+			normalize3(next);
+
+			const double c1 = dot3(v1, v1);
+			total += sqrt(c1);
+			if (c1 > 0.0) {
+				const double fr = 2.0 * dot3(v1, r) / c1;
+				const double ft = 2.0 * dot3(v1, t) / c1;
+				for (unsigned k = 0; k < 3; k++) {
+					rL[k] = r[k] - fr * v1[k];
+					tL[k] = t[k] - ft * v1[k];
+				}
+			}
+			else {
+				for (unsigned k = 0; k < 3; k++) {
+					rL[k] = r[k];
+					tL[k] = t[k];
+				}
+			}
+
+			double v2[3];
+			for (unsigned k = 0; k < 3; k++)
+				v2[k] = next[k] - tL[k];
+			const double c2 = dot3(v2, v2);
+			const double f2 = (c2 > 0.0) ? 2.0 * dot3(v2, rL) / c2 : 0.0;
+			for (unsigned k = 0; k < 3; k++) {
+				r[k] = rL[k] - f2 * v2[k];
+				t[k] = next[k];
+			}
+		}
+
+		double* point = &frames.point[3 * (size_t) i];
+		double* normal = &frames.normal[3 * (size_t) i];
+		double* binormal = &frames.binormal[3 * (size_t) i];
+		for (unsigned k = 0; k < 3; k++) {
+			point[k] = points[i][k];
+			normal[k] = r[k];
+		}
+		binormal[0] = r[1] * t[2] - r[2] * t[1];
+		binormal[1] = r[2] * t[0] - r[0] * t[2];
+		binormal[2] = r[0] * t[1] - r[1] * t[0];
+		frames.length[i] = total;
+	}
+}
+
+unsigned helixCoilCVs(const helixPathFrames& frames, double cvRadius,
+	double rise, bool reversed, unsigned numCVs, double (*cvs)[4])
+{
+	if (frames.count == 0)
+		return 0;
+
+	const double end = frames.length[frames.count - 1];
+	const double turn = reversed ? -1.0 : 1.0;
+	unsigned sample = 0;
+	unsigned i;
+
+	for (i = 0; i < numCVs; i++) {
+		const double s = rise * (double) i;
+		if (s > end)
+			break;
+		while (sample + 2 < frames.count && frames.length[sample + 1] < s)
+			sample++;
+
+		// Frame at s, interpolated between the samples around it.
+		const unsigned next = (sample + 1 < frames.count) ? sample + 1 : sample;
+		const double span = frames.length[next] - frames.length[sample];
+		double f = (span > 0.0) ? (s - frames.length[sample]) / span : 0.0;
+		if (f > 1.0)
+			f = 1.0;
+
+		const double c = cvRadius * cos((double) i);
+		const double sn = turn * cvRadius * sin((double) i);
+		const double* p0 = &frames.point[3 * (size_t) sample];
+		const double* p1 = &frames.point[3 * (size_t) next];
+		const double* n0 = &frames.normal[3 * (size_t) sample];
+		const double* n1 = &frames.normal[3 * (size_t) next];
+		const double* b0 = &frames.binormal[3 * (size_t) sample];
+		const double* b1 = &frames.binormal[3 * (size_t) next];
+		for (unsigned k = 0; k < 3; k++) {
+			const double p = p0[k] + f * (p1[k] - p0[k]);
+			const double n = n0[k] + f * (n1[k] - n0[k]);
+			const double b = b0[k] + f * (b1[k] - b0[k]);
+			cvs[i][k] = p + c * n + sn * b;
+		}
+		cvs[i][3] = 1.0;
+	}
+
+	return i;
+}
@@ -0,0 +1,299 @@
+#ifndef _helixGeometry
+#define _helixGeometry
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixGeometry.h
+//
+// Description:
+//     Analytic helix geometry shared by the helix commands and nodes.
+//
+//     helixTool places CV i at (r cos i, h i, r sin i), where h is the
+//     pitch, negated for upside down helices, and joins the CVs with a
+//     uniform cubic B-spline. That curve is a helix about the Y axis
+//     with a radius of r (2 + cos 1) / 3, to within 0.4%. Its angle
+//     runs from 1 to numCVs - 2 radians (curve parameter minus 1).
+//     The functions here work on that ideal helix, so the geometry
+//     they produce lies on the curve rather than on the CV hull.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <maya/MIntArray.h>
+#include <maya/MFloatArray.h>
+
+#include <vector>
+
+// Radius of the curve through helixTool's CVs, for a CV radius.
+//
+inline double helixCurveRadius(double cvRadius)
+{
+	return cvRadius * 0.84676743906040316;		// (2 + cos 1) / 3
+}
+
+// A tube swept around a helix.
+//
+struct helixSpringDesc
+{
+	double			radius;			// Radius of the helix centre line
+	double			rise;			// Height gained per radian
+	double			tubeRadius;
+	double			startAngle;		// Angle of the first ring
+	double			endAngle;		// Angle of the last ring
+	unsigned		segments;		// Faces along the tube
+	unsigned		sides;			// Faces around the tube
+};
+
+// Topology of a spring mesh: segments + 1 rings of sides vertices,
+// with sides + 1 UVs per ring so the texture does not wrap across a
+// seam. It depends only on segments and sides, so it is built once
+// for each pair and shared by every spring that uses them.
+//
+class helixSpringTopology
+{
+public:
+	unsigned		segments;
+	unsigned		sides;
+	int				numVertices;
+	int				numPolygons;
+	MIntArray		polygonCounts;
+	MIntArray		polygonConnects;
+	MFloatArray		uArray;
+	MFloatArray		vArray;
+	MIntArray		uvCounts;
+	MIntArray		uvIds;
+	MIntArray		vertexList;		// 0 .. numVertices-1, for normals
+};
+
+// Returns the cached topology for segments and sides, building it on
+// first use. Call from the main thread only.
+//
+const helixSpringTopology& helixGetSpringTopology(unsigned segments, unsigned sides);
+
+// Frees every cached topology.
+//
+void helixClearSpringTopologies();
+
+// Writes the vertices and normals of rings [firstRing, endRing) of a
+// spring. points and normals hold the whole mesh, ring by ring, in
+// the vertex order of helixSpringTopology. Each ring is independent
+// of the others.
+//
+void helixSpringRings(const helixSpringDesc& desc,
+	unsigned firstRing, unsigned endRing,
+	float (*points)[4], double (*normals)[3]);
+
+// Writes every ring of a spring, splitting large springs into ring
+// ranges run on Maya's thread pool. Every ring is computed by the
+// same code whichever thread runs it, so the output is bit for bit
+// the same as a single call to helixSpringRings.
+//
+void helixSpringRingsParallel(const helixSpringDesc& desc,
+	float (*points)[4], double (*normals)[3]);
+
+// Level of detail for drawing a helix whose curve radius covers
+// pixelRadius pixels on screen. Returns segments per radian: 0 for a
+// helix too small to show its coils, otherwise a power of two giving
+// roughly one segment per four pixels of arc, up to 16.
+//
+unsigned helixLodSegmentsPerRadian(double pixelRadius);
+
+// Number of polyline points drawn for a helix of numCVs CVs at a
+// level from helixLodSegmentsPerRadian. Level 0 draws the axis only.
+// Never more than 2^24, however many CVs the helix has.
+//
+unsigned helixPolylineSamples(unsigned numCVs, unsigned segmentsPerRadian);
+
+// Writes samples points evenly spaced in angle along the curve of a
+// helix, as x y z floats, placed by matrix (row vectors, as MMatrix).
+// Needs no viewport, so draw code built on it can be checked offline.
+//
+void helixPolyline(double cvRadius, double rise, unsigned numCVs,
+	unsigned samples, const double matrix[4][4], float* xyz);
+
+// Closest approach of a ray to the curve of a helix, both in the
+// helix's own space. Only the part of the curve within tolerance of
+// the ray's path through the helix's cylinder is searched. Returns
+// false when nothing is within tolerance; otherwise distance is the
+// distance between ray and curve, angle the curve's angle there and
+// rayParam the distance along the (unit) direction.
+//
+bool helixRayDistance(double cvRadius, double rise, unsigned numCVs,
+	const double origin[3], const double direction[3], double tolerance,
+	double& distance, double& angle, double& rayParam);
+
+// Entries in a baked pitch ramp.
+//
+#define kPitchTableSize		256
+
+// Bakes a piecewise linear ramp, count positions (ascending, in 0..1)
+// and their values, into kPitchTableSize evenly spaced samples. Past
+// the first and last positions the ramp is flat; an empty ramp is 1.
+//
+void helixBakePitchTable(const double* positions, const double* values,
+	unsigned count, float* table);
+
+// Writes the CVs of a tapered, variable pitch helix. The CV radius
+// runs linearly from radius to endRadius, and the rise per radian
+// at a fraction u of the way along is rise times pitchTable at u
+// (a table from helixBakePitchTable, or NULL for a constant pitch).
+// With endRadius equal to radius and no table, the CVs are the
+// same as helixTool's plain helix.
+//
+void helixProfileCVs(double radius, double endRadius, double rise,
+	const float* pitchTable, unsigned numCVs, double (*cvs)[4]);
+
+// Writes CVs first to end - 1 of the helix of helixProfileCVs, at
+// their own places in cvs, so a long helix can be built a piece at a
+// time. height carries the pitch table's running height from one
+// piece to the next: start it at 0 and pass it back unchanged.
+//
+void helixProfileCVRange(double radius, double endRadius, double rise,
+	const float* pitchTable, unsigned numCVs, unsigned first, unsigned end,
+	double& height, double (*cvs)[4]);
+
+// Number of knots of the degree 3 curve of a helix with numCVs CVs.
+//
+unsigned helixCurveKnotCount(unsigned numCVs);
+
+// The CVs and knots of the degree 3 curve that helixToolCmd and
+// helixNode build for a helix: the CVs of helixProfileCVs and the
+// knots 0, 1, 2, ..., helixCurveKnotCount of them. Either output may
+// be NULL. Both build their curves through this, so a helix comes
+// out the same from either.
+//
+void helixCurve(double radius, double endRadius, double rise,
+	const float* pitchTable, unsigned numCVs, double (*cvs)[4],
+	double* knots);
+
+// Writes strands helices of numCVs CVs each, strand after strand,
+// with strand k turned 2 pi k / strands about Y. The first strand is
+// built by helixProfileCVs and every other strand is rotated from
+// it, so the cos/sin of the CV angles are computed once for all.
+//
+void helixStrandCVs(double radius, double endRadius, double rise,
+	const float* pitchTable, unsigned numCVs, unsigned strands,
+	double (*cvs)[4]);
+
+// Closest points on the curve of a helix to count query points, all
+// in the helix's own space. The closed form of the ideal helix gives
+// the candidate coils to search and a start on each; Newton steps on
+// the curve's own cubic span, whose CVs are known in closed form,
+// then make the result exact for the NURBS curve. params are Maya
+// curve parameters (angle plus one). Large batches are split over
+// Maya's thread pool.
+//
+void helixClosestPoints(double cvRadius, double rise, unsigned numCVs,
+	const double (*points)[3], unsigned count,
+	double (*closest)[3], double* params, double* distances);
+
+// Arc length of the curve of a helix. Every span of the curve is the
+// same shape, so this is the number of spans times the length of one,
+// found once by Gauss-Legendre quadrature.
+//
+double helixArcLength(double cvRadius, double rise, unsigned numCVs);
+
+// Writes count points spaced evenly by arc length along the curve of
+// a helix, from its start to its end, with their curve parameters.
+// Large batches are split over Maya's thread pool.
+//
+void helixResample(double cvRadius, double rise, unsigned numCVs,
+	unsigned count, double (*points)[3], double* params);
+
+// Like helixResample, and also the Euler rotations, in radians and
+// XYZ order, of a frame at each point for instancing: X along the
+// curve, Z out from the helix's axis. The spacing comes from a table
+// of the span's length, good to about 1e-9 of a span rather than to
+// rounding as helixResample's is.
+//
+void helixInstanceFrames(double cvRadius, double rise, unsigned numCVs,
+	unsigned count, double (*positions)[3], double (*rotations)[3],
+	double* params);
+
+// A chain of count joints along the curve of a helix, spaced evenly
+// by arc length, with the frames of helixInstanceFrames. Each joint's
+// translation and orientation (radians, XYZ order) are relative to
+// the joint before it; the first joint's are in the helix's space.
+//
+void helixJointFrames(double cvRadius, double rise, unsigned numCVs,
+	unsigned count, double (*translates)[3], double (*orients)[3]);
+
+// Parameters of helixTool's helix found from the CVs of a curve.
+// matrix (row vectors) places the tool's helix, built about Y from
+// the origin, onto the CVs; residual is the RMS distance from the
+// CVs to the fitted ones.
+//
+struct helixFit
+{
+	bool			fitted;			// False if the CVs are not helical,
+									// or fit fewer than 4 tool CVs
+	double			radius;
+	double			pitch;
+	unsigned		numCVs;
+	bool			upsideDown;		// Left handed
+	double			matrix[4][4];
+	double			residual;
+	double			cvRadius;		// Of the CVs themselves, and their
+	double			turn;			// radians and rise per CV, before
+	double			rise;			// rescaling to the tool's one radian
+};
+
+// Fits a helix to count CVs by least squares in three linear steps:
+//     - the axis is the mean cross product of successive second
+//       differences of the CVs, which point at the axis;
+//     - the centre and radius come from a Kasa circle fit to the CVs
+//       projected across the axis;
+//     - regressions of the unwrapped angle on the CV index, and of
+//       the height on the angle, give the turn per CV and the pitch,
+//       whose sign is the handedness.
+// CVs are assumed to be evenly spaced in angle, as helixTool's are.
+//
+void helixFitCVs(const double (*cvs)[3], unsigned count, helixFit& fit);
+
+// Fits curves independently on Maya's thread pool. Curve c has the
+// CVs from offsets[c] up to offsets[c + 1].
+//
+void helixFitBatch(const double (*cvs)[3], const unsigned* offsets,
+	unsigned curves, helixFit* fits);
+
+// Rotation minimizing frames at samples along a path. The binormal
+// is normal x tangent, so a straight path up the Y axis, whose first
+// normal is X, gives the frame of helixTool's own helices.
+//
+struct helixPathFrames
+{
+	unsigned			count;		// Samples
+	std::vector<double>	length;		// Arc length to each sample
+	std::vector<double>	point;		// x y z per sample
+	std::vector<double>	normal;		// x y z per sample
+	std::vector<double>	binormal;	// x y z per sample
+};
+
+// Builds frames from count path points and tangents by the double
+// reflection method (Wang et al., 2008): each frame is the previous
+// one reflected across the bisector plane of the chord, then across
+// the plane between the reflected and actual tangents. Tangents need
+// not be unit length.
+//
+void helixBuildPathFrames(const double (*points)[3], const double (*tangents)[3],
+	unsigned count, helixPathFrames& frames);
+
+// Writes the CVs of a helix coiled around a path: CV i is cvRadius
+// from the path, at angle i (or -i when reversed) in the frame found
+// rise * i along it. CVs advance monotonically, so the frames are
+// walked once. Stops at the end of the path and returns the number
+// of CVs written, at most numCVs.
+//
+unsigned helixCoilCVs(const helixPathFrames& frames, double cvRadius,
+	double rise, bool reversed, unsigned numCVs, double (*cvs)[4]);
+
+#endif
@@ -0,0 +1,888 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixIO.cpp
+//
+// Description:
+//     Memory mapping, and the binary and text helix file formats
+//     described in helixIO.h.
+//
+////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <string.h>
+#include <math.h>
+
+#include "helixIO.h"
+
+/////////////////////////////////////////////////////////////
+// Little-endian encoding
+/////////////////////////////////////////////////////////////
+
+static unsigned getU32(const unsigned char* p)
+{
+	return (unsigned) p[0] | ((unsigned) p[1] << 8) |
+		((unsigned) p[2] << 16) | ((unsigned) p[3] << 24);
+}
+
+static MUint64 getU64(const unsigned char* p)
+{
+	return (MUint64) getU32(p) | ((MUint64) getU32(p + 4) << 32);
+}
+
+static double getDouble(const unsigned char* p)
+{
+	MUint64 bits = getU64(p);
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static void putU32(unsigned char* p, unsigned value)
+{
+	p[0] = (unsigned char) value;
+	p[1] = (unsigned char) (value >> 8);
+	p[2] = (unsigned char) (value >> 16);
+	p[3] = (unsigned char) (value >> 24);
+}
+
+static void putU64(unsigned char* p, MUint64 value)
+{
+	putU32(p, (unsigned) value);
+	putU32(p + 4, (unsigned) (value >> 32));
+}
+
+static void putDouble(unsigned char* p, double value)
+{
+	MUint64 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	putU64(p, bits);
+}
+
+/////////////////////////////////////////////////////////////
+// helixMappedFile
+/////////////////////////////////////////////////////////////
+
+helixMappedFile::helixMappedFile()
+	: fData(NULL)
+	, fSize(0)
+#ifdef _WIN32
+	, fFile(INVALID_HANDLE_VALUE)
+	, fMapping(NULL)
+#endif
+{
+}
+
+helixMappedFile::~helixMappedFile()
+{
+	close();
+}
+
+// What an empty file maps to, so that it opens like any other and
+// simply has nothing in it.
+static const char emptyFile[1] = { 0 };
+
+bool helixMappedFile::open(const char* path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		CloseHandle(file);
+		return false;
+	}
+	if (size.QuadPart == 0) {
+		// Empty files cannot be mapped.
+		CloseHandle(file);
+		fData = emptyFile;
+		return true;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) {
+		CloseHandle(file);
+		return false;
+	}
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == NULL) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	fFile = file;
+	fMapping = mapping;
+	fData = (const char*) data;
+	fSize = (size_t) size.QuadPart;
+#else
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		::close(fd);
+		return false;
+	}
+	if (info.st_size == 0) {
+		// Empty files cannot be mapped.
+		::close(fd);
+		fData = emptyFile;
+		return true;
+	}
+
+	void* data = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED)
+		return false;
+
+	madvise(data, (size_t) info.st_size, MADV_SEQUENTIAL);
+
+	fData = (const char*) data;
+	fSize = (size_t) info.st_size;
+#endif
+
+	return true;
+}
+
+void helixMappedFile::close()
+{
+	if (fData == NULL)
+		return;
+
+	if (fData != emptyFile) {
+#ifdef _WIN32
+		UnmapViewOfFile(fData);
+		CloseHandle(fMapping);
+		CloseHandle(fFile);
+		fMapping = NULL;
+		fFile = INVALID_HANDLE_VALUE;
+#else
+		munmap((void*) fData, fSize);
+#endif
+	}
+
+	fData = NULL;
+	fSize = 0;
+}
+
+bool helixMappedFile::isOpen() const
+{
+	return fData != NULL;
+}
+
+const char* helixMappedFile::data() const
+{
+	return fData;
+}
+
+size_t helixMappedFile::size() const
+{
+	return fSize;
+}
+
+/////////////////////////////////////////////////////////////
+// helixBinaryReader
+/////////////////////////////////////////////////////////////
+
+helixBinaryReader::helixBinaryReader()
+	: fRecordSize(0)
+	, fCount(0)
+{
+}
+
+MStatus helixBinaryReader::open(const MString& path)
+	//
+	// Description
+	//     Maps the file and checks its header. Records are decoded
+	//     one at a time by read(), nothing is copied up front.
+	//
+{
+	close();
+
+	if (!fFile.open(path.asChar())) {
+		MStatus stat(MS::kNotFound);
+		stat.perror(MString("cannot open helix file ") + path);
+		return stat;
+	}
+
+	const unsigned char* header = (const unsigned char*) fFile.data();
+	if (fFile.size() < kHelixFileHeaderSize ||
+		memcmp(header, kHelixFileMagic, 4) != 0) {
+		close();
+		MStatus stat(MS::kInvalidParameter);
+		stat.perror(path + " is not a binary helix file");
+		return stat;
+	}
+
+	unsigned version = getU32(header + 4);
+	unsigned recordSize = getU32(header + 8);
+	MUint64 count = getU64(header + 16);
+
+	if (version != kHelixFileVersion || recordSize < kHelixFileRecordSize) {
+		close();
+		MStatus stat(MS::kInvalidParameter);
+		stat.perror(path + ": unsupported helix file version");
+		return stat;
+	}
+
+	MUint64 available = (fFile.size() - kHelixFileHeaderSize) / recordSize;
+	if (count > available) {
+		close();
+		MStatus stat(MS::kInvalidParameter);
+		stat.perror(path + ": helix file is truncated");
+		return stat;
+	}
+
+	fRecordSize = recordSize;
+	fCount = count;
+	return MS::kSuccess;
+}
+
+void helixBinaryReader::close()
+{
+	fFile.close();
+	fRecordSize = 0;
+	fCount = 0;
+}
+
+bool helixBinaryReader::isOpen() const
+{
+	return fFile.isOpen();
+}
+
+MUint64 helixBinaryReader::count() const
+{
+	return fCount;
+}
+
+void helixBinaryReader::read(MUint64 index, helixFileRecord& record) const
+{
+	const unsigned char* p = (const unsigned char*) fFile.data() +
+		kHelixFileHeaderSize + (size_t) (index * fRecordSize);
+
+	record.radius = getDouble(p);
+	record.pitch = getDouble(p + 8);
+	record.numCV = getU32(p + 16);
+	record.upsideDown = (getU32(p + 20) & 1) != 0;
+	for (unsigned row = 0; row < 4; row++)
+		for (unsigned col = 0; col < 4; col++)
+			record.matrix[row][col] = getDouble(p + 24 + 8 * (row * 4 + col));
+}
+
+/////////////////////////////////////////////////////////////
+// Text parsing
+/////////////////////////////////////////////////////////////
+
+static const double kPowersOf10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static bool parseNumber(const char*& p, const char* end, double& value)
+	//
+	// Description
+	//     Parses a decimal number starting at p and moves p past it.
+	//     Unlike strtod this needs no terminating NUL, so it can read
+	//     the mapping directly, and it does not depend on the locale.
+	//     Values with up to 15 significant digits and exponents within
+	//     +/-22 are converted exactly.
+	//
+{
+	const char* s = p;
+	bool negative = false;
+	if (s < end && (*s == '-' || *s == '+')) {
+		negative = (*s == '-');
+		s++;
+	}
+
+	MUint64 mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool any = false;
+
+	for (; s < end && isDigit(*s); s++) {
+		any = true;
+		if (digits < 19) {
+			mantissa = mantissa * 10 + (unsigned) (*s - '0');
+			if (mantissa != 0)
+				digits++;
+		}
+		else
+			exponent++;
+	}
+
+	if (s < end && *s == '.') {
+		for (s++; s < end && isDigit(*s); s++) {
+			any = true;
+			if (digits < 19) {
+				mantissa = mantissa * 10 + (unsigned) (*s - '0');
+				if (mantissa != 0)
+					digits++;
+				exponent--;
+			}
+		}
+	}
+
+	if (!any)
+		return false;
+
+	if (s < end && (*s == 'e' || *s == 'E')) {
+		const char* e = s + 1;
+		bool negativeExponent = false;
+		if (e < end && (*e == '-' || *e == '+')) {
+			negativeExponent = (*e == '-');
+			e++;
+		}
+		if (e < end && isDigit(*e)) {
+			int power = 0;
+			for (; e < end && isDigit(*e); e++) {
+				if (power < 100000)
+					power = power * 10 + (*e - '0');
+			}
+			exponent += negativeExponent ? -power : power;
+			s = e;
+		}
+	}
+
+	double result = (double) mantissa;
+	if (exponent > 0 && exponent <= 22)
+		result *= kPowersOf10[exponent];
+	else if (exponent < 0 && exponent >= -22)
+		result /= kPowersOf10[-exponent];
+	else if (exponent != 0)
+		result *= pow(10.0, (double) exponent);
+
+	value = negative ? -result : result;
+	p = s;
+	return true;
+}
+
+static bool sameName(const char* begin, const char* end, const char* name)
+	//
+	// Description
+	//     Case insensitive comparison of [begin, end) with name.
+	//
+{
+	for (; begin < end; begin++, name++) {
+		char a = *begin, b = *name;
+		if (a >= 'A' && a <= 'Z') a = (char) (a - 'A' + 'a');
+		if (b >= 'A' && b <= 'Z') b = (char) (b - 'A' + 'a');
+		if (b == '\0' || a != b)
+			return false;
+	}
+	return *name == '\0';
+}
+
+static unsigned fieldFromName(const char* begin, const char* end)
+{
+	if (sameName(begin, end, "radius"))		return helixTextRecord::kRadius;
+	if (sameName(begin, end, "pitch"))		return helixTextRecord::kPitch;
+	if (sameName(begin, end, "numCVs"))		return helixTextRecord::kNumCVs;
+	if (sameName(begin, end, "upsideDown"))	return helixTextRecord::kUpsideDown;
+	if (sameName(begin, end, "tx"))			return helixTextRecord::kTranslateX;
+	if (sameName(begin, end, "ty"))			return helixTextRecord::kTranslateY;
+	if (sameName(begin, end, "tz"))			return helixTextRecord::kTranslateZ;
+	return 0;
+}
+
+static bool parseField(const char*& p, const char* end, unsigned field,
+	helixTextRecord& record)
+	//
+	// Description
+	//     Parses the value of one field at p. Booleans are accepted as
+	//     true/false or as numbers.
+	//
+{
+	double value;
+
+	if (end - p >= 4 && strncmp(p, "true", 4) == 0) {
+		value = 1.0;
+		p += 4;
+	}
+	else if (end - p >= 5 && strncmp(p, "false", 5) == 0) {
+		value = 0.0;
+		p += 5;
+	}
+	else if (!parseNumber(p, end, value))
+		return false;
+
+	switch (field) {
+		case helixTextRecord::kRadius:		record.radius = value; break;
+		case helixTextRecord::kPitch:		record.pitch = value; break;
+		case helixTextRecord::kUpsideDown:	record.upsideDown = (value != 0.0); break;
+		case helixTextRecord::kTranslateX:	record.translate[0] = value; break;
+		case helixTextRecord::kTranslateY:	record.translate[1] = value; break;
+		case helixTextRecord::kTranslateZ:	record.translate[2] = value; break;
+		case helixTextRecord::kNumCVs:
+			if (value < 0.0 || value > 4294967295.0 || value != floor(value))
+				return false;
+			record.numCV = (unsigned) value;
+			break;
+		default:
+			return false;
+	}
+
+	record.present |= field;
+	return true;
+}
+
+static void skipBlanks(const char*& p, const char* end)
+{
+	while (p < end && (*p == ' ' || *p == '\t'))
+		p++;
+}
+
+static void skipWhitespace(const char*& p, const char* end, unsigned& line)
+{
+	for (; p < end; p++) {
+		if (*p == '\n')
+			line++;
+		else if (*p != ' ' && *p != '\t' && *p != '\r')
+			break;
+	}
+}
+
+static void skipLine(const char*& p, const char* end, unsigned& line)
+{
+	while (p < end && *p != '\n')
+		p++;
+	if (p < end) {
+		p++;
+		line++;
+	}
+}
+
+static bool skipString(const char*& p, const char* end)
+	//
+	// Description
+	//     Moves p from an opening quote to just past the closing one.
+	//
+{
+	for (p++; p < end; p++) {
+		if (*p == '\\')
+			p++;
+		else if (*p == '"') {
+			p++;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool skipValue(const char*& p, const char* end, unsigned& line)
+	//
+	// Description
+	//     Skips a JSON value of a field we do not use, including any
+	//     nested objects or arrays.
+	//
+{
+	int depth = 0;
+	while (p < end) {
+		char c = *p;
+		if (c == '"') {
+			if (!skipString(p, end))
+				return false;
+			continue;
+		}
+		if (depth == 0 && (c == ',' || c == '}' || c == ']'))
+			return true;
+		if (c == '{' || c == '[')
+			depth++;
+		else if (c == '}' || c == ']')
+			depth--;
+		else if (c == '\n')
+			line++;
+		p++;
+	}
+	return false;
+}
+
+/////////////////////////////////////////////////////////////
+// helixTextReader
+/////////////////////////////////////////////////////////////
+
+helixTextReader::helixTextReader()
+	: fFormat(kCSV)
+	, fCursor(NULL)
+	, fEnd(NULL)
+	, fLine(0)
+	, fInArray(false)
+	, fNumColumns(0)
+{
+}
+
+MStatus helixTextReader::open(const MString& path)
+	//
+	// Description
+	//     Maps the file and works out its format from the first
+	//     character: JSON starts with [ or {, anything else is CSV.
+	//
+{
+	close();
+
+	if (!fFile.open(path.asChar())) {
+		MStatus stat(MS::kNotFound);
+		stat.perror(MString("cannot open helix file ") + path);
+		return stat;
+	}
+
+	fPath = path;
+	fCursor = fFile.data();
+	fEnd = fCursor + fFile.size();
+	fLine = 1;
+
+	// Skip a UTF-8 byte order mark.
+	if (fEnd - fCursor >= 3 && memcmp(fCursor, "\xEF\xBB\xBF", 3) == 0)
+		fCursor += 3;
+
+	skipWhitespace(fCursor, fEnd, fLine);
+
+	if (fCursor < fEnd && (*fCursor == '[' || *fCursor == '{')) {
+		fFormat = kJSON;
+		fInArray = (*fCursor == '[');
+		if (fInArray)
+			fCursor++;
+		return MS::kSuccess;
+	}
+
+	fFormat = kCSV;
+	MStatus stat = readHeader();
+	if (!stat)
+		close();
+	return stat;
+}
+
+void helixTextReader::close()
+{
+	fFile.close();
+	fCursor = fEnd = NULL;
+	fInArray = false;
+	fNumColumns = 0;
+}
+
+bool helixTextReader::isOpen() const
+{
+	return fFile.isOpen();
+}
+
+double helixTextReader::progress() const
+{
+	if (!fFile.isOpen() || fFile.size() == 0)
+		return 1.0;
+	return (double) (fCursor - fFile.data()) / (double) fFile.size();
+}
+
+MStatus helixTextReader::error(const char* message) const
+{
+	MString text(fPath);
+	text += ":";
+	text += fLine;
+	text += ": ";
+	text += message;
+
+	MStatus stat(MS::kInvalidParameter);
+	stat.perror(text);
+	return stat;
+}
+
+MStatus helixTextReader::readHeader()
+	//
+	// Description
+	//     Maps each CSV column named in the header line to a field.
+	//     A file with no header has no records either, which is
+	//     left for the caller to report.
+	//
+{
+	fNumColumns = 0;
+	for (;;) {
+		skipBlanks(fCursor, fEnd);
+		if (fCursor >= fEnd)
+			return MS::kSuccess;
+		if (*fCursor != '#' && *fCursor != '\n' && *fCursor != '\r')
+			break;
+		skipLine(fCursor, fEnd, fLine);
+	}
+
+	unsigned known = 0;
+	fNumColumns = 0;
+	for (;;) {
+		skipBlanks(fCursor, fEnd);
+		const char* begin = fCursor;
+		while (fCursor < fEnd && *fCursor != ',' && *fCursor != '\n' && *fCursor != '\r')
+			fCursor++;
+		const char* end = fCursor;
+		while (end > begin && (end[-1] == ' ' || end[-1] == '\t'))
+			end--;
+		if (end - begin >= 2 && *begin == '"' && end[-1] == '"') {
+			begin++;
+			end--;
+		}
+
+		if (fNumColumns == kMaxColumns)
+			return error("too many CSV columns");
+		unsigned field = fieldFromName(begin, end);
+		fColumns[fNumColumns++] = field;
+		if (field)
+			known++;
+
+		if (fCursor < fEnd && *fCursor == ',') {
+			fCursor++;
+			continue;
+		}
+		break;
+	}
+
+	skipLine(fCursor, fEnd, fLine);
+
+	if (known == 0)
+		return error("CSV header names no helix fields");
+	return MS::kSuccess;
+}
+
+MStatus helixTextReader::next(helixTextRecord& record, bool& done)
+{
+	done = false;
+	if (!isOpen()) {
+		done = true;
+		return MS::kSuccess;
+	}
+	return (fFormat == kJSON) ? nextJSON(record, done) : nextCSV(record, done);
+}
+
+MStatus helixTextReader::nextCSV(helixTextRecord& record, bool& done)
+{
+	// Skip blank and comment lines.
+	for (;;) {
+		skipBlanks(fCursor, fEnd);
+		if (fCursor >= fEnd) {
+			done = true;
+			return MS::kSuccess;
+		}
+		if (*fCursor != '#' && *fCursor != '\n' && *fCursor != '\r')
+			break;
+		skipLine(fCursor, fEnd, fLine);
+	}
+
+	record.present = 0;
+	record.line = fLine;
+
+	for (unsigned column = 0; ; column++) {
+		skipBlanks(fCursor, fEnd);
+
+		if (column < fNumColumns && fColumns[column] != 0) {
+			const char* value = fCursor;
+			if (value < fEnd && *value == '"')
+				value++;
+			if (!parseField(value, fEnd, fColumns[column], record))
+				return error("bad value in CSV column");
+			fCursor = value;
+			if (fCursor < fEnd && *fCursor == '"')
+				fCursor++;
+			skipBlanks(fCursor, fEnd);
+		}
+		else {
+			while (fCursor < fEnd && *fCursor != ',' && *fCursor != '\n' && *fCursor != '\r')
+				fCursor++;
+		}
+
+		if (fCursor < fEnd && *fCursor == ',') {
+			fCursor++;
+			continue;
+		}
+		if (fCursor < fEnd && *fCursor != '\n' && *fCursor != '\r')
+			return error("unexpected character in CSV line");
+		break;
+	}
+
+	skipLine(fCursor, fEnd, fLine);
+	return MS::kSuccess;
+}
+
+MStatus helixTextReader::nextJSON(helixTextRecord& record, bool& done)
+{
+	skipWhitespace(fCursor, fEnd, fLine);
+
+	if (fInArray && fCursor < fEnd && *fCursor == ',') {
+		fCursor++;
+		skipWhitespace(fCursor, fEnd, fLine);
+	}
+
+	if (fCursor >= fEnd) {
+		if (fInArray)
+			return error("unterminated JSON array");
+		done = true;
+		return MS::kSuccess;
+	}
+
+	if (fInArray && *fCursor == ']') {
+		fCursor = fEnd;
+		done = true;
+		return MS::kSuccess;
+	}
+
+	if (*fCursor != '{')
+		return error("expected a JSON object");
+
+	record.present = 0;
+	record.line = fLine;
+
+	fCursor++;
+	skipWhitespace(fCursor, fEnd, fLine);
+	if (fCursor < fEnd && *fCursor == '}') {
+		fCursor++;
+		return MS::kSuccess;
+	}
+
+	for (;;) {
+		if (fCursor >= fEnd || *fCursor != '"')
+			return error("expected a quoted JSON key");
+		const char* key = fCursor + 1;
+		if (!skipString(fCursor, fEnd))
+			return error("unterminated JSON string");
+		const char* keyEnd = fCursor - 1;
+
+		skipWhitespace(fCursor, fEnd, fLine);
+		if (fCursor >= fEnd || *fCursor != ':')
+			return error("expected ':' after JSON key");
+		fCursor++;
+		skipWhitespace(fCursor, fEnd, fLine);
+
+		unsigned field = fieldFromName(key, keyEnd);
+		if (field) {
+			if (!parseField(fCursor, fEnd, field, record))
+				return error("bad value for helix field");
+		}
+		else if (!skipValue(fCursor, fEnd, fLine))
+			return error("unterminated JSON value");
+
+		skipWhitespace(fCursor, fEnd, fLine);
+		if (fCursor < fEnd && *fCursor == ',') {
+			fCursor++;
+			skipWhitespace(fCursor, fEnd, fLine);
+			continue;
+		}
+		if (fCursor < fEnd && *fCursor == '}') {
+			fCursor++;
+			break;
+		}
+		return error("expected ',' or '}' in JSON object");
+	}
+
+	return MS::kSuccess;
+}
+
+/////////////////////////////////////////////////////////////
+// helixBinaryWriter
+/////////////////////////////////////////////////////////////
+
+helixBinaryWriter::helixBinaryWriter()
+	: fFile(NULL)
+	, fCount(0)
+{
+}
+
+helixBinaryWriter::~helixBinaryWriter()
+{
+	close();
+}
+
+MStatus helixBinaryWriter::open(const MString& path)
+{
+	close();
+
+	fFile = fopen(path.asChar(), "wb");
+	if (fFile == NULL) {
+		MStatus stat(MS::kFailure);
+		stat.perror(MString("cannot write helix file ") + path);
+		return stat;
+	}
+
+	// The count is patched in close(), once it is known.
+	unsigned char header[kHelixFileHeaderSize];
+	memcpy(header, kHelixFileMagic, 4);
+	putU32(header + 4, kHelixFileVersion);
+	putU32(header + 8, kHelixFileRecordSize);
+	putU32(header + 12, 0);
+	putU64(header + 16, 0);
+
+	fCount = 0;
+	if (fwrite(header, sizeof(header), 1, fFile) != 1) {
+		close();
+		return MS::kFailure;
+	}
+
+	return MS::kSuccess;
+}
+
+MStatus helixBinaryWriter::write(const helixFileRecord& record)
+{
+	unsigned char p[kHelixFileRecordSize];
+
+	putDouble(p, record.radius);
+	putDouble(p + 8, record.pitch);
+	putU32(p + 16, record.numCV);
+	putU32(p + 20, record.upsideDown ? 1 : 0);
+	for (unsigned row = 0; row < 4; row++)
+		for (unsigned col = 0; col < 4; col++)
+			putDouble(p + 24 + 8 * (row * 4 + col), record.matrix[row][col]);
+
+	if (fFile == NULL || fwrite(p, sizeof(p), 1, fFile) != 1)
+		return MS::kFailure;
+
+	fCount++;
+	return MS::kSuccess;
+}
+
+MStatus helixBinaryWriter::close()
+{
+	if (fFile == NULL)
+		return MS::kSuccess;
+
+	unsigned char count[8];
+	putU64(count, fCount);
+
+	bool ok = fseek(fFile, 16, SEEK_SET) == 0 &&
+		fwrite(count, sizeof(count), 1, fFile) == 1;
+	ok = (fclose(fFile) == 0) && ok;
+	fFile = NULL;
+
+	return ok ? MS::kSuccess : MS::kFailure;
+}
+
+MUint64 helixBinaryWriter::count() const
+{
+	return fCount;
+}
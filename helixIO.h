@@ -0,0 +1,228 @@
+#ifndef _helixIO
+#define _helixIO
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixIO.h
+//
+// Description:
+//     Reading and writing helix parameter files.
+//
+//     Binary helix file, version 1. All values are little-endian and
+//     records are packed with no padding.
+//
+//       Header (24 bytes)
+//         offset  size  contents
+//              0     4  magic "HLXB"
+//              4     4  uint32 version, currently 1
+//              8     4  uint32 record size in bytes, at least 152
+//             12     4  uint32 reserved, written as 0
+//             16     8  uint64 number of records
+//
+//       Record (152 bytes in version 1)
+//         offset  size  contents
+//              0     8  double radius
+//              8     8  double pitch
+//             16     4  uint32 number of CVs
+//             20     4  uint32 flags, bit 0 set for upside down
+//             24   128  double[4][4] transform matrix, row major,
+//                       translation in the last row (as MMatrix)
+//
+//     Readers must honour the record size from the header and ignore
+//     any bytes past the fields they know, so later versions can
+//     append fields to a record without breaking older readers.
+//
+//     Text helix files, either CSV or JSON, carry the same fields by
+//     name: radius, pitch, numCVs, upsideDown, and tx, ty, tz for the
+//     position. Fields left out take the command's defaults and
+//     unknown fields are ignored.
+//
+//       CSV   A header line naming the columns, then one helix per
+//             line. Blank lines and lines starting with # are
+//             skipped.
+//
+//               radius,pitch,numCVs,upsideDown,tx,ty,tz
+//               1.5,0.25,40,0,0,0,10
+//
+//       JSON  An array of flat objects, or one object per line.
+//
+//               [ { "radius": 1.5, "pitch": 0.25, "numCVs": 40,
+//                   "upsideDown": false, "tx": 0, "ty": 0, "tz": 10 } ]
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include <maya/MTypes.h>
+#include <maya/MString.h>
+#include <maya/MStatus.h>
+
+#define kHelixFileMagic			"HLXB"
+#define kHelixFileVersion		1
+#define kHelixFileHeaderSize	24
+#define kHelixFileRecordSize	152
+
+// One helix as stored in a helix file.
+//
+struct helixFileRecord
+{
+	double			radius;
+	double			pitch;
+	unsigned		numCV;
+	bool			upsideDown;
+	double			matrix[4][4];
+};
+
+// Read-only memory mapping of a whole file. Pages are brought in by
+// the OS as they are touched, so walking the records front to back
+// never holds more than a few pages of the file in memory. An empty
+// file opens with a size of 0.
+//
+class helixMappedFile
+{
+public:
+	helixMappedFile();
+	~helixMappedFile();
+
+	bool			open(const char* path);
+	void			close();
+	bool			isOpen() const;
+	const char*		data() const;
+	size_t			size() const;
+
+private:
+	helixMappedFile(const helixMappedFile&);
+	helixMappedFile& operator=(const helixMappedFile&);
+
+	const char*		fData;
+	size_t			fSize;
+#ifdef _WIN32
+	void*			fFile;
+	void*			fMapping;
+#endif
+};
+
+// Random access to the records of a memory mapped binary helix file.
+//
+class helixBinaryReader
+{
+public:
+	helixBinaryReader();
+
+	MStatus			open(const MString& path);
+	void			close();
+	bool			isOpen() const;
+	MUint64			count() const;
+	void			read(MUint64 index, helixFileRecord& record) const;
+
+private:
+	helixMappedFile	fFile;
+	unsigned		fRecordSize;
+	MUint64			fCount;
+};
+
+// One helix read from a text file. Only the fields flagged in
+// present were found in the file.
+//
+struct helixTextRecord
+{
+	enum Field
+	{
+		kRadius		= 1 << 0,
+		kPitch		= 1 << 1,
+		kNumCVs		= 1 << 2,
+		kUpsideDown	= 1 << 3,
+		kTranslateX	= 1 << 4,
+		kTranslateY	= 1 << 5,
+		kTranslateZ	= 1 << 6
+	};
+
+	unsigned		present;
+	double			radius;
+	double			pitch;
+	unsigned		numCV;
+	bool			upsideDown;
+	double			translate[3];
+	unsigned		line;			// Line the record starts on
+};
+
+// Streaming parser for CSV and JSON helix files. The file is memory
+// mapped and parsed in place: values are converted straight from the
+// mapping, without copying lines or building a document.
+//
+class helixTextReader
+{
+public:
+	enum Format
+	{
+		kCSV,
+		kJSON
+	};
+
+	helixTextReader();
+
+	MStatus			open(const MString& path);
+	void			close();
+	bool			isOpen() const;
+
+	// Parses the next record. done is set, and record left alone,
+	// once the end of the file is reached.
+	MStatus			next(helixTextRecord& record, bool& done);
+
+	// Fraction of the file parsed so far, from 0 to 1.
+	double			progress() const;
+
+private:
+	enum { kMaxColumns = 64 };
+
+	MStatus			readHeader();
+	MStatus			nextCSV(helixTextRecord& record, bool& done);
+	MStatus			nextJSON(helixTextRecord& record, bool& done);
+	MStatus			error(const char* message) const;
+
+	helixMappedFile	fFile;
+	MString			fPath;
+	Format			fFormat;
+	const char*		fCursor;
+	const char*		fEnd;
+	unsigned		fLine;
+	bool			fInArray;
+	unsigned		fNumColumns;
+	unsigned		fColumns[kMaxColumns];	// Field of each CSV column,
+											// 0 for ignored columns
+};
+
+// Streams records to a binary helix file. The record count in the
+// header is patched when the writer is closed.
+//
+class helixBinaryWriter
+{
+public:
+	helixBinaryWriter();
+	~helixBinaryWriter();
+
+	MStatus			open(const MString& path);
+	MStatus			write(const helixFileRecord& record);
+	MStatus			close();
+	MUint64			count() const;
+
+private:
+	helixBinaryWriter(const helixBinaryWriter&);
+	helixBinaryWriter& operator=(const helixBinaryWriter&);
+
+	FILE*			fFile;
+	MUint64			fCount;
+};
+
+#endif
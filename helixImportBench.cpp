@@ -0,0 +1,217 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixImportBench.cpp
+//
+// Description:
+//     A headless benchmark of the helix file readers, outside Maya:
+//     1,000,000 helices are written as CSV, as JSON and as a binary
+//     helix file, and each file is then parsed front to back, as
+//     helixToolCmd -importFile does in its checking pass. It is not
+//     part of the plug-in. helixIO needs only MString and MStatus,
+//     from Maya's Foundation library, so Maya itself is not started:
+//
+//         c++ -O2 -I$MAYA_LOCATION/include helixImportBench.cpp
+//             helixIO.cpp -L$MAYA_LOCATION/lib -lFoundation
+//             -o helixImportBench
+//
+//     Usage:
+//
+//         helixImportBench [rows [directory]]
+//
+//     The files are written to directory (the current one by
+//     default) as helixImportBench.csv, .json and .hlx, and left
+//     there. A reader that returns the wrong number of records, or
+//     the wrong values, fails the run.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+
+#include "helixIO.h"
+
+#define kBenchRows			1000000
+
+// The values of row i, so that every reader can check what it read.
+static double rowRadius(unsigned i)	{ return 1.0 + (double) (i % 97) * 0.125; }
+static double rowPitch(unsigned i)	{ return 0.25 + (double) (i % 13) * 0.5; }
+static unsigned rowNumCVs(unsigned i)	{ return 20 + i % 200; }
+static bool rowUpsideDown(unsigned i)	{ return (i & 1) != 0; }
+static double rowX(unsigned i)		{ return (double) (i % 1000) * 10.0; }
+static double rowZ(unsigned i)		{ return (double) (i / 1000) * 10.0; }
+
+static bool writeText(const std::string& path, unsigned rows, bool json)
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (file == NULL)
+		return false;
+
+	if (json)
+		fputs("[\n", file);
+	else
+		fputs("radius,pitch,numCVs,upsideDown,tx,ty,tz\n", file);
+
+	for (unsigned i = 0; i < rows; i++) {
+		if (json) {
+			fprintf(file, "{ \"radius\": %.17g, \"pitch\": %.17g, \"numCVs\": %u, "
+				"\"upsideDown\": %s, \"tx\": %.17g, \"ty\": 0, \"tz\": %.17g }%s\n",
+				rowRadius(i), rowPitch(i), rowNumCVs(i),
+				rowUpsideDown(i) ? "true" : "false", rowX(i), rowZ(i),
+				i + 1 < rows ? "," : "");
+		}
+		else {
+			fprintf(file, "%.17g,%.17g,%u,%d,%.17g,0,%.17g\n",
+				rowRadius(i), rowPitch(i), rowNumCVs(i),
+				rowUpsideDown(i) ? 1 : 0, rowX(i), rowZ(i));
+		}
+	}
+
+	if (json)
+		fputs("]\n", file);
+	return fclose(file) == 0;
+}
+
+static bool writeBinary(const std::string& path, unsigned rows)
+{
+	helixBinaryWriter writer;
+	if (!writer.open(MString(path.c_str())))
+		return false;
+
+	helixFileRecord record;
+	memset(&record, 0, sizeof(record));
+	for (unsigned i = 0; i < rows; i++) {
+		record.radius = rowRadius(i);
+		record.pitch = rowPitch(i);
+		record.numCV = rowNumCVs(i);
+		record.upsideDown = rowUpsideDown(i);
+		for (unsigned j = 0; j < 4; j++)
+			record.matrix[j][j] = 1.0;
+		record.matrix[3][0] = rowX(i);
+		record.matrix[3][2] = rowZ(i);
+		if (!writer.write(record))
+			return false;
+	}
+	return (bool) writer.close();
+}
+
+static bool sameRow(unsigned i, double radius, double pitch, unsigned numCV,
+	bool upsideDown, double x, double z)
+{
+	return radius == rowRadius(i) && pitch == rowPitch(i) &&
+		numCV == rowNumCVs(i) && upsideDown == rowUpsideDown(i) &&
+		x == rowX(i) && z == rowZ(i);
+}
+
+static MUint64 parseText(const std::string& path, unsigned rows, bool& ok)
+	//
+	// Description
+	//     Reads every record, returning how many there were. ok is
+	//     cleared if any record is not the one written.
+	//
+{
+	helixTextReader reader;
+	ok = (bool) reader.open(MString(path.c_str()));
+
+	MUint64 count = 0;
+	helixTextRecord record;
+	bool done = false;
+	while (ok) {
+		ok = (bool) reader.next(record, done);
+		if (!ok || done)
+			break;
+		if (count >= rows || !sameRow((unsigned) count, record.radius,
+				record.pitch, record.numCV, record.upsideDown,
+				record.translate[0], record.translate[2]))
+			ok = false;
+		count++;
+	}
+	return count;
+}
+
+static MUint64 parseBinary(const std::string& path, unsigned rows, bool& ok)
+{
+	helixBinaryReader reader;
+	ok = (bool) reader.open(MString(path.c_str()));
+	if (!ok)
+		return 0;
+
+	helixFileRecord record;
+	const MUint64 count = reader.count();
+	for (MUint64 i = 0; ok && i < count; i++) {
+		reader.read(i, record);
+		if (i >= rows || !sameRow((unsigned) i, record.radius, record.pitch,
+				record.numCV, record.upsideDown,
+				record.matrix[3][0], record.matrix[3][2]))
+			ok = false;
+	}
+	return count;
+}
+
+static bool report(const char* format, const std::string& path, unsigned rows,
+	bool binary)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	long bytes = 0;
+	if (file != NULL) {
+		fseek(file, 0, SEEK_END);
+		bytes = ftell(file);
+		fclose(file);
+	}
+
+	bool ok;
+	const clock_t start = clock();
+	const MUint64 count = binary ? parseBinary(path, rows, ok) :
+		parseText(path, rows, ok);
+	const double seconds = (double) (clock() - start) / (double) CLOCKS_PER_SEC;
+
+	if (!ok || count != rows) {
+		printf("%-6s FAILED after %llu of %u records\n", format,
+			(unsigned long long) count, rows);
+		return false;
+	}
+
+	printf("%-6s %u records, %.1f MB: %.1f ms, %.1f ns per record, %.0f MB/s\n",
+		format, rows, (double) bytes / 1.0e6, 1000.0 * seconds,
+		1.0e9 * seconds / (double) rows,
+		seconds > 0.0 ? (double) bytes / 1.0e6 / seconds : 0.0);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	const unsigned rows = (argc > 1) ? (unsigned) atoi(argv[1]) : kBenchRows;
+	const std::string directory = (argc > 2) ? std::string(argv[2]) + "/" : std::string();
+	if (rows == 0) {
+		fprintf(stderr, "usage: %s [rows [directory]]\n", argv[0]);
+		return 1;
+	}
+
+	const std::string csv = directory + "helixImportBench.csv";
+	const std::string json = directory + "helixImportBench.json";
+	const std::string binary = directory + "helixImportBench.hlx";
+	if (!writeText(csv, rows, false) || !writeText(json, rows, true) ||
+		!writeBinary(binary, rows)) {
+		fprintf(stderr, "%s: cannot write the benchmark files\n", argv[0]);
+		return 1;
+	}
+
+	bool ok = report("CSV", csv, rows, false);
+	ok = report("JSON", json, rows, false) && ok;
+	ok = report("binary", binary, rows, true) && ok;
+	return ok ? 0 : 1;
+}
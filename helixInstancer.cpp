@@ -0,0 +1,170 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixInstancer.cpp
+//
+// Description:
+//     A dependency node that lays out instances along a helix. See
+//     helixInstancer.h.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <maya/MPlug.h>
+#include <maya/MDataBlock.h>
+#include <maya/MDataHandle.h>
+#include <maya/MFnNumericAttribute.h>
+#include <maya/MFnTypedAttribute.h>
+#include <maya/MFnArrayAttrsData.h>
+#include <maya/MVector.h>
+#include <maya/MVectorArray.h>
+
+#include <vector>
+
+#include "helixInstancer.h"
+#include "helixGeometry.h"
+
+#define PI 3.1415926535897932
+
+const MTypeId helixInstancer::id( kHelixInstancerId );
+const MString helixInstancer::typeName( "helixInstancer" );
+
+MObject helixInstancer::radius;
+MObject helixInstancer::pitch;
+MObject helixInstancer::numCVs;
+MObject helixInstancer::upsideDown;
+MObject helixInstancer::count;
+MObject helixInstancer::outputPoints;
+
+helixInstancer::helixInstancer() {}
+helixInstancer::~helixInstancer() {}
+
+void* helixInstancer::creator()
+{
+	return new helixInstancer;
+}
+
+MStatus helixInstancer::initialize()
+{
+	MStatus stat;
+	MFnNumericAttribute numAttr;
+	MFnTypedAttribute typedAttr;
+
+	radius = numAttr.create("radius", "r", MFnNumericData::kDouble, 4.0, &stat);
+	numAttr.setKeyable(true);
+	numAttr.setMin(0.0);
+
+	pitch = numAttr.create("pitch", "p", MFnNumericData::kDouble, 0.5, &stat);
+	numAttr.setKeyable(true);
+	numAttr.setMin(0.0);
+
+	numCVs = numAttr.create("numCVs", "ncv", MFnNumericData::kInt, 20, &stat);
+	numAttr.setKeyable(true);
+	numAttr.setMin(4);
+
+	upsideDown = numAttr.create("upsideDown", "ud", MFnNumericData::kBoolean, 0, &stat);
+	numAttr.setKeyable(true);
+
+	count = numAttr.create("count", "cnt", MFnNumericData::kInt, 100, &stat);
+	numAttr.setKeyable(true);
+	numAttr.setMin(0);
+
+	outputPoints = typedAttr.create("outputPoints", "opt", MFnData::kDynArrayAttrs, &stat);
+	typedAttr.setWritable(false);
+	typedAttr.setStorable(false);
+
+	MObject* inputs[] = { &radius, &pitch, &numCVs, &upsideDown, &count };
+	for (unsigned i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+		stat = addAttribute(*inputs[i]);
+		if (!stat) {
+			stat.perror("addAttribute");
+			return stat;
+		}
+	}
+	stat = addAttribute(outputPoints);
+	if (!stat) {
+		stat.perror("addAttribute outputPoints");
+		return stat;
+	}
+
+	for (unsigned i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+		stat = attributeAffects(*inputs[i], outputPoints);
+		if (!stat) {
+			stat.perror("attributeAffects");
+			return stat;
+		}
+	}
+
+	return MS::kSuccess;
+}
+
+MStatus helixInstancer::compute(const MPlug& plug, MDataBlock& data)
+	//
+	// Description
+	//     Places every instance at once, then copies the positions and
+	//     rotations into the output's position and rotation arrays.
+	//
+{
+	MStatus stat;
+
+	if (plug != outputPoints)
+		return MS::kUnknownParameter;
+
+	const double r = data.inputValue(radius).asDouble();
+	const double p = data.inputValue(pitch).asDouble();
+	const bool upDown = data.inputValue(upsideDown).asBool();
+	int ncvs = data.inputValue(numCVs).asInt();
+	if (ncvs < 4)
+		ncvs = 4;
+	int instances = data.inputValue(count).asInt();
+	if (instances < 0)
+		instances = 0;
+	const unsigned n = (unsigned) instances;
+
+	MFnArrayAttrsData arrayFn;
+	MObject arrays = arrayFn.create(&stat);
+	if (!stat) {
+		stat.perror("helixInstancer: creating outputPoints");
+		return stat;
+	}
+
+	// The arrays refer to the data's own, so they are filled in place.
+	MStatus rotationStat;
+	MVectorArray positions = arrayFn.vectorArray("position", &stat);
+	MVectorArray rotations = arrayFn.vectorArray("rotation", &rotationStat);
+	if (!stat || !rotationStat) {
+		stat.perror("helixInstancer: creating outputPoints");
+		return MS::kFailure;
+	}
+
+	if (n > 0) {
+		std::vector<double> placed(3 * (size_t) n);
+		std::vector<double> turned(3 * (size_t) n);
+		std::vector<double> params(n);
+		helixInstanceFrames(r, upDown ? -p : p, (unsigned) ncvs, n,
+			(double (*)[3]) &placed[0], (double (*)[3]) &turned[0], &params[0]);
+
+		const double toDegrees = 180.0 / PI;
+		positions.setLength(n);
+		rotations.setLength(n);
+		for (unsigned i = 0; i < n; i++) {
+			positions.set(MVector(placed[3 * i], placed[3 * i + 1], placed[3 * i + 2]), i);
+			rotations.set(MVector(turned[3 * i] * toDegrees, turned[3 * i + 1] * toDegrees,
+				turned[3 * i + 2] * toDegrees), i);
+		}
+	}
+
+	MDataHandle output = data.outputValue(outputPoints);
+	output.set(arrays);
+	output.setClean();
+	return MS::kSuccess;
+}
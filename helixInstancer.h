@@ -0,0 +1,67 @@
+#ifndef _helixInstancer
+#define _helixInstancer
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixInstancer.h
+//
+// Description:
+//     A dependency node that lays out instances along a helix, for
+//     steps, beads or chain links.
+//
+//     From the same parameters as helixNode, it places count
+//     instances evenly by arc length along the helix's curve, ends
+//     included, and writes their positions and rotations as the
+//     array attributes an instancer reads:
+//
+//         connectAttr helixInstancer1.outputPoints instancer1.inputPoints;
+//
+//     Each instance's X axis runs along the curve and its Z axis
+//     points out from the helix's axis. Rotations are in degrees and
+//     XYZ order, the instancer's defaults. All instances are placed
+//     in one pass by helixInstanceFrames(), so the layout follows
+//     changes to radius and pitch interactively for 100k instances.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <maya/MPxNode.h>
+#include <maya/MTypeId.h>
+#include <maya/MString.h>
+
+#define kHelixInstancerId		0x00081443
+
+class helixInstancer : public MPxNode
+{
+public:
+					helixInstancer();
+	virtual			~helixInstancer();
+	static void*	creator();
+	static MStatus	initialize();
+
+	virtual MStatus	compute(const MPlug& plug, MDataBlock& data);
+
+	static const MTypeId	id;
+	static const MString	typeName;
+
+	// Inputs
+	static MObject	radius;
+	static MObject	pitch;
+	static MObject	numCVs;
+	static MObject	upsideDown;
+	static MObject	count;
+
+	// Output
+	static MObject	outputPoints;
+};
+
+#endif
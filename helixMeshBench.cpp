@@ -0,0 +1,176 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixMeshBench.cpp
+//
+// Description:
+//     A headless benchmark of the spring mesh vertices: one spring of
+//     1,000,000 vertices is built by helixSpringRings on this thread,
+//     then by helixSpringRingsParallel with Maya's thread pool at 1,
+//     2, 4 ... threads, up to the machine's thread count. Each
+//     parallel result must match the serial one bit for bit. It is
+//     not part of the plug-in. The pool needs Maya's libraries, so it
+//     runs as a Maya standalone application:
+//
+//         c++ -O2 -I$MAYA_LOCATION/include helixMeshBench.cpp
+//             helixGeometry.cpp -L$MAYA_LOCATION/lib -lOpenMaya
+//             -lFoundation -o helixMeshBench
+//
+//     Usage:
+//
+//         helixMeshBench [vertices [repeats]]
+//
+//     The fastest of repeats runs is reported for each thread count,
+//     with its speedup over the serial build.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include <maya/MLibrary.h>
+#include <maya/MGlobal.h>
+#include <maya/MString.h>
+#include <maya/MThreadPool.h>
+#include <maya/MTimer.h>
+
+#include "helixGeometry.h"
+
+#define kBenchVertices		1000000
+#define kBenchRepeats		5
+#define kBenchSides			8
+#define kBenchSegmentsPerRadian	4
+
+struct springBuffers
+{
+	std::vector<float>	points;
+	std::vector<double>	normals;
+};
+
+static double timeRings(const helixSpringDesc& desc, bool parallel,
+	unsigned repeats, springBuffers& out)
+	//
+	// Description
+	//     The fastest of repeats builds of every ring, in seconds of
+	//     wall clock time.
+	//
+{
+	const size_t vertices = (size_t) (desc.segments + 1) * desc.sides;
+	out.points.assign(4 * vertices, 0.0f);
+	out.normals.assign(3 * vertices, 0.0);
+	float (*points)[4] = (float (*)[4]) &out.points[0];
+	double (*normals)[3] = (double (*)[3]) &out.normals[0];
+
+	double best = 0.0;
+	for (unsigned r = 0; r < repeats; r++) {
+		MTimer timer;
+		timer.beginTimer();
+		if (parallel)
+			helixSpringRingsParallel(desc, points, normals);
+		else
+			helixSpringRings(desc, 0, desc.segments + 1, points, normals);
+		timer.endTimer();
+		if (r == 0 || timer.elapsedTime() < best)
+			best = timer.elapsedTime();
+	}
+	return best;
+}
+
+static bool setThreads(unsigned threads)
+	//
+	// Description
+	//     Restarts the pool with the given number of threads.
+	//
+{
+	MThreadPool::release();
+	MString command("threadCount -n ");
+	command += threads;
+	const bool set = (bool) MGlobal::executeCommand(command);
+	MThreadPool::init();
+	return set;
+}
+
+static int run(unsigned vertices, unsigned repeats)
+{
+	helixSpringDesc desc;
+	desc.radius = 4.0;
+	desc.rise = 0.5 / 6.283185307179586;
+	desc.tubeRadius = 0.1;
+	desc.sides = kBenchSides;
+	desc.segments = vertices / kBenchSides - 1;
+	desc.startAngle = 0.0;
+	desc.endAngle = (double) desc.segments / kBenchSegmentsPerRadian;
+
+	springBuffers serial;
+	const double serialTime = timeRings(desc, false, repeats, serial);
+	printf("%u vertices, %u sides, serial: %.2f ms\n",
+		(desc.segments + 1) * desc.sides, desc.sides, 1000.0 * serialTime);
+
+	int threadCount = 1;
+	MGlobal::executeCommand("threadCount -q -n", threadCount);
+	if (threadCount < 1)
+		threadCount = 1;
+
+	bool same = true;
+	for (unsigned threads = 1; ; threads *= 2) {
+		if (threads > (unsigned) threadCount)
+			threads = (unsigned) threadCount;
+
+		if (!setThreads(threads)) {
+			printf("threadCount -n %u failed, using the default pool\n", threads);
+			threads = (unsigned) threadCount;
+		}
+
+		springBuffers parallel;
+		const double parallelTime = timeRings(desc, true, repeats, parallel);
+		const bool match = memcmp(&parallel.points[0], &serial.points[0],
+				parallel.points.size() * sizeof(float)) == 0 &&
+			memcmp(&parallel.normals[0], &serial.normals[0],
+				parallel.normals.size() * sizeof(double)) == 0;
+		same = same && match;
+
+		printf("%2u threads: %.2f ms, %.2fx serial%s\n", threads,
+			1000.0 * parallelTime, serialTime / parallelTime,
+			match ? "" : ", OUTPUT DIFFERS");
+
+		if (threads >= (unsigned) threadCount)
+			break;
+	}
+	return same ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+	const unsigned vertices = (argc > 1) ? (unsigned) atoi(argv[1]) : kBenchVertices;
+	const unsigned repeats = (argc > 2) ? (unsigned) atoi(argv[2]) : kBenchRepeats;
+	if (vertices < 2 * kBenchSides || repeats == 0) {
+		fprintf(stderr, "usage: %s [vertices [repeats]]\n", argv[0]);
+		return 1;
+	}
+
+	MStatus stat = MLibrary::initialize(argv[0]);
+	if (!stat) {
+		stat.perror("MLibrary::initialize");
+		return 1;
+	}
+	MThreadPool::init();
+
+	const int result = run(vertices, repeats);
+
+	MThreadPool::release();
+	MLibrary::cleanup(result, false);
+	return result;
+}
@@ -0,0 +1,182 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixNode.cpp
+//
+// Description:
+//     A dependency node that builds the helixTool curve from its
+//     parameters. See helixNode.h.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+
+#include <maya/MPlug.h>
+#include <maya/MDataBlock.h>
+#include <maya/MDataHandle.h>
+#include <maya/MFnNumericAttribute.h>
+#include <maya/MFnTypedAttribute.h>
+#include <maya/MFnNurbsCurve.h>
+#include <maya/MFnNurbsCurveData.h>
+#include <maya/MPoint.h>
+#include <maya/MPointArray.h>
+#include <maya/MDoubleArray.h>
+#include <maya/MRampAttribute.h>
+
+#include <vector>
+
+#include "helixNode.h"
+#include "helixGeometry.h"
+
+const MTypeId helixNode::id( kHelixNodeId );
+const MString helixNode::typeName( "helixNode" );
+
+MObject helixNode::radius;
+MObject helixNode::pitch;
+MObject helixNode::numCVs;
+MObject helixNode::upsideDown;
+MObject helixNode::tapered;
+MObject helixNode::endRadius;
+MObject helixNode::pitchRamp;
+MObject helixNode::outputCurve;
+
+helixNode::helixNode() {}
+helixNode::~helixNode() {}
+
+void* helixNode::creator()
+{
+	return new helixNode;
+}
+
+MStatus helixNode::initialize()
+{
+	MStatus stat;
+	MFnNumericAttribute numAttr;
+	MFnTypedAttribute typedAttr;
+
+	radius = numAttr.create("radius", "r", MFnNumericData::kDouble, 4.0, &stat);
+	numAttr.setKeyable(true);
+	numAttr.setMin(0.0);
+
+	pitch = numAttr.create("pitch", "p", MFnNumericData::kDouble, 0.5, &stat);
+	numAttr.setKeyable(true);
+	numAttr.setMin(0.0);
+
+	numCVs = numAttr.create("numCVs", "ncv", MFnNumericData::kInt, 20, &stat);
+	numAttr.setKeyable(true);
+	numAttr.setMin(4);
+
+	upsideDown = numAttr.create("upsideDown", "ud", MFnNumericData::kBoolean, 0, &stat);
+	numAttr.setKeyable(true);
+
+	tapered = numAttr.create("tapered", "tp", MFnNumericData::kBoolean, 0, &stat);
+	numAttr.setKeyable(true);
+
+	endRadius = numAttr.create("endRadius", "er", MFnNumericData::kDouble, 4.0, &stat);
+	numAttr.setKeyable(true);
+	numAttr.setMin(0.0);
+
+	pitchRamp = MRampAttribute::createCurveRamp("pitchRamp", "pr", &stat);
+	if (!stat) {
+		stat.perror("createCurveRamp pitchRamp");
+		return stat;
+	}
+
+	outputCurve = typedAttr.create("outputCurve", "oc", MFnData::kNurbsCurve, &stat);
+	typedAttr.setWritable(false);
+	typedAttr.setStorable(false);
+
+	MObject* inputs[] = { &radius, &pitch, &numCVs, &upsideDown,
+		&tapered, &endRadius, &pitchRamp };
+	for (unsigned i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+		stat = addAttribute(*inputs[i]);
+		if (!stat) {
+			stat.perror("addAttribute");
+			return stat;
+		}
+	}
+	stat = addAttribute(outputCurve);
+	if (!stat) {
+		stat.perror("addAttribute outputCurve");
+		return stat;
+	}
+
+	for (unsigned i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+		stat = attributeAffects(*inputs[i], outputCurve);
+		if (!stat) {
+			stat.perror("attributeAffects");
+			return stat;
+		}
+	}
+
+	return MS::kSuccess;
+}
+
+MStatus helixNode::compute(const MPlug& plug, MDataBlock& data)
+	//
+	// Description
+	//     Builds the node's curve with helixCurve(), as helixToolCmd
+	//     does. A ramp with no entries leaves the pitch constant.
+	//
+{
+	MStatus stat;
+
+	if (plug != outputCurve)
+		return MS::kUnknownParameter;
+
+	const double r = data.inputValue(radius).asDouble();
+	const double p = data.inputValue(pitch).asDouble();
+	const int upFactor = data.inputValue(upsideDown).asBool() ? -1 : 1;
+	int count = data.inputValue(numCVs).asInt();
+	if (count < 4)
+		count = 4;
+
+	const unsigned  deg     = 3;            // Curve Degree
+	const unsigned  ncvs    = (unsigned) count;
+	const unsigned  nknots  = helixCurveKnotCount(ncvs);
+
+	const bool taper = data.inputValue(tapered).asBool();
+	MRampAttribute ramp(thisMObject(), pitchRamp, &stat);
+	const bool ramped = stat && ramp.getNumEntries() > 0;
+
+	float table[kPitchTableSize];
+	if (ramped) {
+		for (unsigned j = 0; j < kPitchTableSize; j++)
+			ramp.getValueAtPosition((float) j / (float) (kPitchTableSize - 1), table[j]);
+	}
+
+	std::vector<double> cvs(4 * (size_t) ncvs);
+	std::vector<double> knots(nknots);
+	helixCurve(r, taper ? data.inputValue(endRadius).asDouble() : r,
+		upFactor * p, ramped ? table : NULL, ncvs, (double (*)[4]) &cvs[0], &knots[0]);
+	MPointArray		controlVertices((const double (*)[4]) &cvs[0], ncvs);
+	MDoubleArray	knotSequences(&knots[0], nknots);
+
+	MFnNurbsCurveData dataCreator;
+	MObject curveData = dataCreator.create(&stat);
+	if (!stat)
+		return stat;
+
+	MFnNurbsCurve curveFn;
+	curveFn.create(controlVertices, knotSequences, deg,
+		MFnNurbsCurve::kOpen, false, false, curveData, &stat);
+	if (!stat) {
+		stat.perror("Error creating curve");
+		return stat;
+	}
+
+	MDataHandle output = data.outputValue(outputCurve);
+	output.set(curveData);
+	output.setClean();
+	return MS::kSuccess;
+}
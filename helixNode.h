@@ -0,0 +1,65 @@
+#ifndef _helixNode
+#define _helixNode
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixNode.h
+//
+// Description:
+//     A dependency node that builds the helixTool curve from its
+//     parameters.
+//
+//     Connected to the create attribute of a nurbsCurve shape, the
+//     curve becomes construction history of the node: a scene file
+//     then stores only the node's parameters, and the CVs are built
+//     by the DG when the curve is first evaluated after loading.
+//
+//     With tapered on, the radius runs linearly to endRadius. The
+//     pitch ramp scales the pitch along the helix; it is baked into
+//     a table once per evaluation, not read once per CV.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <maya/MPxNode.h>
+#include <maya/MTypeId.h>
+#include <maya/MString.h>
+
+#define kHelixNodeId			0x00081442
+
+class helixNode : public MPxNode
+{
+public:
+					helixNode();
+	virtual			~helixNode();
+	static void*	creator();
+	static MStatus	initialize();
+
+	virtual MStatus	compute(const MPlug& plug, MDataBlock& data);
+
+	static const MTypeId	id;
+	static const MString	typeName;
+
+	// Inputs
+	static MObject	radius;
+	static MObject	pitch;
+	static MObject	numCVs;
+	static MObject	upsideDown;
+	static MObject	tapered;
+	static MObject	endRadius;
+	static MObject	pitchRamp;
+
+	// Output
+	static MObject	outputCurve;
+};
+
+#endif
@@ -0,0 +1,300 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixQueryCmd.cpp
+//
+// Description:
+//     Closed form queries on helix curves. See helixQueryCmd.h.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+
+#include <maya/MArgList.h>
+#include <maya/MGlobal.h>
+#include <maya/MItSelectionList.h>
+#include <maya/MFnNurbsCurve.h>
+#include <maya/MMatrix.h>
+#include <maya/MPoint.h>
+#include <maya/MPointArray.h>
+#include <maya/MDoubleArray.h>
+
+#include <vector>
+
+#include "helixQueryCmd.h"
+
+#define kClosestPointFlag		"-cp"
+#define kClosestPointFlagLong	"-closestPoint"
+#define kArcLengthFlag			"-al"
+#define kArcLengthFlagLong		"-arcLength"
+#define kResampleFlag			"-rs"
+#define kResampleFlagLong		"-resample"
+#define kToleranceFlag			"-tol"
+#define kToleranceFlagLong		"-tolerance"
+
+// Largest RMS distance of the CVs from the fit, over the radius, for
+// a curve to count as a helix. As for helixFit.
+#define kDefaultTolerance	1.0e-3
+
+const MString helixQueryCmd::commandName( "helixQuery" );
+
+helixQueryCmd::helixQueryCmd()
+{
+	domainStart = 0.0;
+	paramScale = 1.0;
+}
+
+helixQueryCmd::~helixQueryCmd() {}
+
+void* helixQueryCmd::creator()
+{
+	return new helixQueryCmd;
+}
+
+MSyntax helixQueryCmd::newSyntax()
+{
+	MSyntax syntax;
+
+	syntax.addFlag(kClosestPointFlag, kClosestPointFlagLong,
+		MSyntax::kDouble, MSyntax::kDouble, MSyntax::kDouble);
+	syntax.makeFlagMultiUse(kClosestPointFlag);
+	syntax.addFlag(kArcLengthFlag, kArcLengthFlagLong);
+	syntax.addFlag(kResampleFlag, kResampleFlagLong, MSyntax::kUnsigned);
+	syntax.addFlag(kToleranceFlag, kToleranceFlagLong, MSyntax::kDouble);
+
+	// The curve to query; the selection is used when none is given.
+	syntax.setObjectType(MSyntax::kSelectionList, 0, 1);
+
+	return syntax;
+}
+
+MStatus helixQueryCmd::doIt(const MArgList& args)
+{
+	MStatus stat;
+	MArgDatabase argData(syntax(), args, &stat);
+	if (!stat)
+		return stat;
+
+	double tolerance = kDefaultTolerance;
+	if (argData.isFlagSet(kToleranceFlag)) {
+		stat = argData.getFlagArgument(kToleranceFlag, 0, tolerance);
+		if (!stat || !(tolerance > 0.0)) {
+			MGlobal::displayError("tolerance must be greater than 0");
+			return MS::kInvalidParameter;
+		}
+	}
+
+	const char* queries[] = { kClosestPointFlag, kArcLengthFlag, kResampleFlag };
+	unsigned set = 0;
+	for (unsigned i = 0; i < sizeof(queries) / sizeof(queries[0]); i++) {
+		if (argData.isFlagSet(queries[i]))
+			set++;
+	}
+	if (set != 1) {
+		MGlobal::displayError("helixQuery: give one of -closestPoint, -arcLength and -resample");
+		return MS::kInvalidParameter;
+	}
+
+	MSelectionList list;
+	argData.getObjects(list);
+	if (list.length() == 0)
+		MGlobal::getActiveSelectionList(list);
+
+	stat = getHelix(list, tolerance);
+	if (!stat)
+		return stat;
+
+	if (argData.isFlagSet(kClosestPointFlag))
+		return closestPoints(argData);
+	if (argData.isFlagSet(kArcLengthFlag))
+		return arcLength();
+	return resample(argData);
+}
+
+MStatus helixQueryCmd::getHelix(const MSelectionList& list, double tolerance)
+	//
+	// Description
+	//     Finds the first curve in list and fits a helix to its object
+	//     space CVs. Parameters are mapped from the tool's knots, 0 to
+	//     numCVs + 1, onto the curve's own domain, so that curves with
+	//     other uniform knots get their own parameters.
+	//
+{
+	for (MItSelectionList iter(list); !iter.isDone(); iter.next()) {
+		MDagPath path;
+		if (iter.getDagPath(path) && path.extendToShape() &&
+			path.hasFn(MFn::kNurbsCurve)) {
+			curve = path;
+			break;
+		}
+	}
+	if (!curve.isValid()) {
+		MGlobal::displayError("helixQuery: no curve given or selected");
+		return MS::kInvalidParameter;
+	}
+
+	MFnNurbsCurve curveFn(curve);
+	MPointArray points;
+	curveFn.getCVs(points, MSpace::kObject);
+	fit.fitted = false;
+	if (curveFn.degree() == 3 && points.length() >= 4) {
+		std::vector<double> cvs(3 * (size_t) points.length());
+		for (unsigned i = 0; i < points.length(); i++) {
+			cvs[3 * i] = points[i].x;
+			cvs[3 * i + 1] = points[i].y;
+			cvs[3 * i + 2] = points[i].z;
+		}
+		helixFitCVs((const double (*)[3]) &cvs[0], points.length(), fit);
+	}
+	if (!fit.fitted || fit.numCVs < 4 || fit.residual > tolerance * fit.radius) {
+		MGlobal::displayError("helixQuery: " + curve.partialPathName() +
+			" is not a helix");
+		return MS::kInvalidParameter;
+	}
+
+	double domainEnd;
+	curveFn.getKnotDomain(domainStart, domainEnd);
+	paramScale = (domainEnd - domainStart) / (double) (fit.numCVs - 3);
+	return MS::kSuccess;
+}
+
+MStatus helixQueryCmd::closestPoints(const MArgDatabase& argData)
+	//
+	// Description
+	//     Takes the query points into the helix's space, where it runs
+	//     up Y from the origin, answers them together, and brings the
+	//     closest points back out to world space.
+	//
+{
+	MStatus stat;
+	const MMatrix world = toWorld();
+	const MMatrix toHelix = world.inverse();
+
+	const unsigned count = argData.numberOfFlagUses(kClosestPointFlag);
+	MPointArray worldQueries(count);
+	std::vector<double> queries(3 * (size_t) count);
+	for (unsigned i = 0; i < count; i++) {
+		MArgList flagArgs;
+		stat = argData.getFlagArgumentList(kClosestPointFlag, i, flagArgs);
+		MPoint q;
+		if (stat)
+			q.x = flagArgs.asDouble(0, &stat);
+		if (stat)
+			q.y = flagArgs.asDouble(1, &stat);
+		if (stat)
+			q.z = flagArgs.asDouble(2, &stat);
+		if (!stat) {
+			stat.perror("closestPoint flag parsing failed");
+			return stat;
+		}
+
+		worldQueries[i] = q;
+		q *= toHelix;
+		queries[3 * i] = q.x;
+		queries[3 * i + 1] = q.y;
+		queries[3 * i + 2] = q.z;
+	}
+
+	std::vector<double> closest(3 * (size_t) count);
+	std::vector<double> params(count), distances(count);
+	const double rise = fit.upsideDown ? -fit.pitch : fit.pitch;
+	helixClosestPoints(fit.radius, rise, fit.numCVs,
+		(const double (*)[3]) &queries[0], count,
+		(double (*)[3]) &closest[0], &params[0], &distances[0]);
+
+	// Scaling in the transforms changes the distances, so they are
+	// measured again in world space.
+	MDoubleArray result;
+	for (unsigned i = 0; i < count; i++) {
+		MPoint point(closest[3 * i], closest[3 * i + 1], closest[3 * i + 2]);
+		point *= world;
+
+		result.append(point.x);
+		result.append(point.y);
+		result.append(point.z);
+		result.append(domainStart + (params[i] - 2.0) * paramScale);
+		result.append(point.distanceTo(worldQueries[i]));
+	}
+
+	setResult(result);
+	return MS::kSuccess;
+}
+
+MMatrix helixQueryCmd::toWorld() const
+	//
+	// Description
+	//     Takes the helix, as built up Y from the origin, to where the
+	//     curve is in world space.
+	//
+{
+	return MMatrix(fit.matrix) * curve.inclusiveMatrix();
+}
+
+double helixQueryCmd::worldScale() const
+	//
+	// Description
+	//     The scale the helix takes to world space, as the cube root
+	//     of the volume scale. Exact for a uniform scale.
+	//
+{
+	const double volume = fabs(toWorld().det3x3());
+	return pow(volume, 1.0 / 3.0);
+}
+
+MStatus helixQueryCmd::arcLength()
+{
+	const double rise = fit.upsideDown ? -fit.pitch : fit.pitch;
+	setResult(helixArcLength(fit.radius, rise, fit.numCVs) * worldScale());
+	return MS::kSuccess;
+}
+
+MStatus helixQueryCmd::resample(const MArgDatabase& argData)
+	//
+	// Description
+	//     Points evenly spaced by arc length along the whole curve,
+	//     ends included, in world space, with their parameters.
+	//
+{
+	unsigned count = 0;
+	MStatus stat = argData.getFlagArgument(kResampleFlag, 0, count);
+	if (!stat || count < 2) {
+		MGlobal::displayError("resample needs 2 or more points");
+		return MS::kInvalidParameter;
+	}
+
+	std::vector<double> points(3 * (size_t) count);
+	std::vector<double> params(count);
+	const double rise = fit.upsideDown ? -fit.pitch : fit.pitch;
+	helixResample(fit.radius, rise, fit.numCVs, count,
+		(double (*)[3]) &points[0], &params[0]);
+
+	const MMatrix world = toWorld();
+	MDoubleArray result;
+	for (unsigned i = 0; i < count; i++) {
+		MPoint point(points[3 * i], points[3 * i + 1], points[3 * i + 2]);
+		point *= world;
+
+		result.append(point.x);
+		result.append(point.y);
+		result.append(point.z);
+		result.append(domainStart + (params[i] - 2.0) * paramScale);
+	}
+
+	setResult(result);
+	return MS::kSuccess;
+}
+
+bool helixQueryCmd::isUndoable() const
+{
+	return false;
+}
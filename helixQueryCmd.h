@@ -0,0 +1,83 @@
+#ifndef _helixQueryCmd
+#define _helixQueryCmd
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixQueryCmd.h
+//
+// Description:
+//     The helixQuery command answers geometric queries about a helix
+//     curve from its closed form rather than through MFnNurbsCurve.
+//
+//         helixQuery -closestPoint x y z [-closestPoint x y z ...]
+//             [-tolerance t] [curve]
+//
+//     The curve's helix parameters and placement are recovered by
+//     helixFitCVs(), so any helixTool curve works, moved or not, as
+//     does any other curve that fits to within t times its radius.
+//     For each world space point the result holds five values: the
+//     closest point on the curve in world space, its curve parameter
+//     and its distance. The points are all answered in one batch by
+//     helixClosestPoints().
+//
+//         helixQuery -arcLength [curve]
+//         helixQuery -resample n [curve]
+//
+//     -arcLength returns the length of the curve from the closed form
+//     of helixArcLength(). -resample returns n points evenly spaced by
+//     arc length along it, ends included, as x y z and the curve
+//     parameter of each, for placing beads or links without a
+//     findParamFromLength call per point.
+//
+//     Distances and lengths are found in the helix's own space, so
+//     they are exact for transforms without non-uniform scale.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <maya/MPxCommand.h>
+#include <maya/MSyntax.h>
+#include <maya/MDagPath.h>
+#include <maya/MArgDatabase.h>
+#include <maya/MSelectionList.h>
+#include <maya/MMatrix.h>
+
+#include "helixGeometry.h"
+
+class helixQueryCmd : public MPxCommand
+{
+public:
+					helixQueryCmd();
+	virtual			~helixQueryCmd();
+	static void*	creator();
+	static MSyntax	newSyntax();
+
+	virtual MStatus	doIt(const MArgList& args);
+	virtual bool	isUndoable() const;
+
+	static const MString	commandName;
+
+private:
+	MStatus			getHelix(const MSelectionList& list, double tolerance);
+	MStatus			closestPoints(const MArgDatabase& argData);
+	MStatus			arcLength();
+	MStatus			resample(const MArgDatabase& argData);
+	MMatrix			toWorld() const;
+	double			worldScale() const;
+
+	MDagPath		curve;			// The queried curve's shape
+	helixFit		fit;			// Its helix, in its object space
+	double			domainStart;	// Its first curve parameter
+	double			paramScale;		// Its parameters per radian
+};
+
+#endif
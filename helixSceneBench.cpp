@@ -0,0 +1,237 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixSceneBench.cpp
+//
+// Description:
+//     Measures what -procedural buys when a scene is loaded, and checks
+//     that it changes nothing about the curves. It is not part of the
+//     plug-in; it loads the plug-in into Maya as a standalone
+//     application:
+//
+//         c++ -O2 -I$MAYA_LOCATION/include helixSceneBench.cpp
+//             -L$MAYA_LOCATION/lib -lOpenMaya -lFoundation
+//             -o helixSceneBench
+//
+//     Usage:
+//
+//         helixSceneBench [helices [plugin]]
+//
+//     First a sample of helices is built both ways, plain and with
+//     -procedural, and their CVs compared: helixToolCmd and helixNode
+//     both build curves with helixCurve(), so they must agree. Then
+//     100,000 helices are imported each way and saved as
+//     helixSceneBench_curves.mb and helixSceneBench_procedural.mb, and
+//     each file is timed as it is opened and as every curve in it is
+//     evaluated.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <set>
+
+#include <maya/MLibrary.h>
+#include <maya/MGlobal.h>
+#include <maya/MString.h>
+#include <maya/MStatus.h>
+#include <maya/MTimer.h>
+#include <maya/MObject.h>
+#include <maya/MObjectHandle.h>
+#include <maya/MPointArray.h>
+#include <maya/MItDependencyNodes.h>
+#include <maya/MFnNurbsCurve.h>
+
+#define kBenchHelices		100000
+#define kCompareHelices		200
+#define kCompareTolerance	1.0e-9
+
+// The parameters of helix i, varied so the comparison covers both
+// directions and a range of sizes.
+static double helixRadius(unsigned i)	{ return 0.5 + (double) (i % 17) * 0.75; }
+static double helixPitch(unsigned i)	{ return (double) (i % 11) * 0.2; }
+static unsigned helixNumCVs(unsigned i)	{ return 4 + (i * 7) % 300; }
+static bool helixUpsideDown(unsigned i)	{ return (i % 3) == 0; }
+
+static MStatus run(const MString& command)
+{
+	MStatus stat = MGlobal::executeCommand(command);
+	if (!stat)
+		stat.perror(command);
+	return stat;
+}
+
+static MObject newCurve(std::set<unsigned>& seen)
+	//
+	// Description
+	//     The first curve shape not in seen, which is then added.
+	//
+{
+	MObject found;
+	for (MItDependencyNodes it(MFn::kNurbsCurve); !it.isDone(); it.next()) {
+		MObject node = it.thisNode();
+		if (seen.insert(MObjectHandle(node).hashCode()).second && found.isNull())
+			found = node;
+	}
+	return found;
+}
+
+static bool compareCurves()
+	//
+	// Description
+	//     Builds kCompareHelices helices plain and procedurally, and
+	//     compares each pair's CVs.
+	//
+{
+	if (!run("file -f -new"))
+		return false;
+
+	std::set<unsigned> seen;
+	newCurve(seen);
+
+	double worst = 0.0;
+	unsigned compared = 0;
+	for (unsigned i = 0; i < kCompareHelices; i++) {
+		char flags[256];
+		sprintf(flags, " -r %.17g -p %.17g -ncv %u -ud %s",
+			helixRadius(i), helixPitch(i), helixNumCVs(i),
+			helixUpsideDown(i) ? "true" : "false");
+
+		MObject plain, procedural;
+		if (run(MString("helixToolCmd") + flags))
+			plain = newCurve(seen);
+		if (run(MString("helixToolCmd -procedural true") + flags))
+			procedural = newCurve(seen);
+		if (plain.isNull() || procedural.isNull()) {
+			printf("helix %u: could not build both curves\n", i);
+			return false;
+		}
+
+		MPointArray a, b;
+		MFnNurbsCurve(plain).getCVs(a);
+		MFnNurbsCurve(procedural).getCVs(b);
+		if (a.length() != b.length()) {
+			printf("helix %u: %u CVs plain, %u procedural\n", i, a.length(), b.length());
+			return false;
+		}
+		for (unsigned k = 0; k < a.length(); k++) {
+			const double d = a[k].distanceTo(b[k]);
+			if (d > worst)
+				worst = d;
+		}
+		compared++;
+	}
+
+	printf("%u helices built both ways: largest CV difference %g\n", compared, worst);
+	return worst <= kCompareTolerance;
+}
+
+static bool writeHelices(const MString& path, unsigned helices)
+{
+	FILE* file = fopen(path.asChar(), "w");
+	if (file == NULL)
+		return false;
+
+	fputs("radius,pitch,numCVs,upsideDown,tx,ty,tz\n", file);
+	for (unsigned i = 0; i < helices; i++) {
+		fprintf(file, "%.17g,%.17g,%u,%d,%g,0,%g\n",
+			helixRadius(i), helixPitch(i), 4 + i % 60, helixUpsideDown(i) ? 1 : 0,
+			(double) (i % 300) * 20.0, (double) (i / 300) * 20.0);
+	}
+	return fclose(file) == 0;
+}
+
+static long fileSize(const MString& path)
+{
+	FILE* file = fopen(path.asChar(), "rb");
+	if (file == NULL)
+		return 0;
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fclose(file);
+	return size;
+}
+
+static bool timeScene(const char* mode, const MString& csv, unsigned helices)
+	//
+	// Description
+	//     Imports the helices in one mode, saves them, then opens the
+	//     file again and evaluates every curve.
+	//
+{
+	const MString scene = MString("helixSceneBench_") + mode + ".mb";
+
+	if (!run("file -f -new") ||
+		!run(MString("helixToolCmd -importFile \"") + csv + "\"" +
+			(MString(mode) == "procedural" ? " -procedural true" : "")) ||
+		!run(MString("file -rename \"") + scene + "\"") ||
+		!run("file -f -save -type \"mayaBinary\"") ||
+		!run("file -f -new"))
+		return false;
+
+	MTimer timer;
+	timer.beginTimer();
+	if (!run(MString("file -f -o \"") + scene + "\""))
+		return false;
+	timer.endTimer();
+	const double openTime = timer.elapsedTime();
+
+	timer.beginTimer();
+	unsigned curves = 0;
+	MPointArray cvs;
+	for (MItDependencyNodes it(MFn::kNurbsCurve); !it.isDone(); it.next()) {
+		MFnNurbsCurve(it.thisNode()).getCVs(cvs);
+		curves++;
+	}
+	timer.endTimer();
+	const double evaluateTime = timer.elapsedTime();
+
+	printf("%-10s %u helices, %u curves, %.1f MB: open %.2f s, evaluate %.2f s\n",
+		mode, helices, curves, (double) fileSize(scene) / 1.0e6,
+		openTime, evaluateTime);
+	return curves == helices;
+}
+
+int main(int argc, char** argv)
+{
+	const unsigned helices = (argc > 1) ? (unsigned) atoi(argv[1]) : kBenchHelices;
+	const MString plugin = (argc > 2) ? MString(argv[2]) : MString("helixTool");
+	if (helices == 0) {
+		fprintf(stderr, "usage: %s [helices [plugin]]\n", argv[0]);
+		return 1;
+	}
+
+	MStatus stat = MLibrary::initialize(true, argv[0]);
+	if (!stat) {
+		stat.perror("MLibrary::initialize");
+		return 1;
+	}
+
+	bool ok = (bool) run(MString("loadPlugin \"") + plugin + "\"");
+	if (ok)
+		ok = compareCurves();
+
+	const MString csv("helixSceneBench.csv");
+	if (ok)
+		ok = writeHelices(csv, helices);
+	if (ok)
+		ok = timeScene("curves", csv, helices);
+	if (ok)
+		ok = timeScene("procedural", csv, helices);
+
+	const int result = ok ? 0 : 1;
+	MLibrary::cleanup(result, false);
+	return result;
+}
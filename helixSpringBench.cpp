@@ -0,0 +1,140 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixSpringBench.cpp
+//
+// Description:
+//     A headless benchmark of helixSpringSolver, outside Maya: 10,000
+//     helices of 200 particles each, stepped for a number of frames.
+//     It is not part of the plug-in. Build it with the solver alone,
+//     which then steps every helix on one thread:
+//
+//         c++ -O2 -DHELIX_SPRING_SERIAL helixSpringBench.cpp
+//             helixSpringSolver.cpp -o helixSpringBench
+//
+//     Usage:
+//
+//         helixSpringBench [helices [particles [frames]]]
+//
+//     Before timing, one helix of each of two turns per CV is stepped
+//     without gravity, and how far it moves is printed: a helix built
+//     at rest should not move at all.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <vector>
+
+#include "helixSpringSolver.h"
+
+#define kBenchHelices		10000
+#define kBenchParticles		200
+#define kBenchFrames		10
+#define kBenchSubsteps		4
+#define kBenchFrameTime		(1.0 / 24.0)
+
+static void buildHelix(double cvRadius, double turn, double rise,
+	double offset, unsigned count, double (*cvs)[3])
+{
+	for (unsigned i = 0; i < count; i++) {
+		const double a = turn * (double) i;
+		cvs[i][0] = cvRadius * cos(a) + offset;
+		cvs[i][1] = rise * (double) i;
+		cvs[i][2] = cvRadius * sin(a);
+	}
+}
+
+static double restDrift(double turn, const helixSpringSettings& settings)
+	//
+	// Description
+	//     The furthest a helix built at rest moves in a second.
+	//
+{
+	const double cvRadius = 4.0;
+	const double rise = 0.5;
+	std::vector<double> cvs(3 * kBenchParticles);
+	buildHelix(cvRadius, turn, rise, 0.0, kBenchParticles, (double (*)[3]) &cvs[0]);
+
+	double rest[kHelixSpringKinds];
+	helixSpringRestLengths(cvRadius, turn, rise, rest);
+
+	helixSpringSolver solver;
+	solver.addHelix((const double (*)[3]) &cvs[0], kBenchParticles, rest);
+	solver.step(settings, 1.0, 24 * kBenchSubsteps);
+
+	std::vector<double> out(3 * kBenchParticles);
+	solver.getPositions(0, (double (*)[3]) &out[0]);
+	double drift = 0.0;
+	for (size_t i = 0; i < out.size(); i++) {
+		if (fabs(out[i] - cvs[i]) > drift)
+			drift = fabs(out[i] - cvs[i]);
+	}
+	return drift;
+}
+
+int main(int argc, char** argv)
+{
+	const unsigned helices = (argc > 1) ? (unsigned) atoi(argv[1]) : kBenchHelices;
+	const unsigned particles = (argc > 2) ? (unsigned) atoi(argv[2]) : kBenchParticles;
+	const unsigned frames = (argc > 3) ? (unsigned) atoi(argv[3]) : kBenchFrames;
+	if (helices == 0 || particles < 2 || frames == 0) {
+		fprintf(stderr, "usage: %s [helices [particles [frames]]]\n", argv[0]);
+		return 1;
+	}
+
+	helixSpringSettings settings;
+	settings.stiffness = 100.0;
+	settings.damping = 1.0;
+	settings.drag = 0.5;
+	settings.mass = 1.0;
+	settings.gravity[0] = 0.0;
+	settings.gravity[1] = 0.0;
+	settings.gravity[2] = 0.0;
+	settings.pinned = 2;
+
+	printf("rest drift, 1 radian per CV:   %g\n", restDrift(1.0, settings));
+	printf("rest drift, 0.5 radian per CV: %g\n", restDrift(0.5, settings));
+
+	settings.gravity[1] = -9.8;
+
+	const double cvRadius = 4.0;
+	const double turn = 1.0;
+	const double rise = 0.5;
+	double rest[kHelixSpringKinds];
+	helixSpringRestLengths(cvRadius, turn, rise, rest);
+
+	helixSpringSolver solver;
+	std::vector<double> cvs(3 * (size_t) particles);
+	for (unsigned h = 0; h < helices; h++) {
+		buildHelix(cvRadius, turn, rise, 10.0 * (double) h, particles,
+			(double (*)[3]) &cvs[0]);
+		solver.addHelix((const double (*)[3]) &cvs[0], particles, rest);
+	}
+
+	const clock_t start = clock();
+	for (unsigned f = 0; f < frames; f++)
+		solver.step(settings, kBenchFrameTime, kBenchSubsteps);
+	const double seconds = (double) (clock() - start) / (double) CLOCKS_PER_SEC;
+
+	const double perFrame = 1000.0 * seconds / (double) frames;
+	const double perParticle = 1.0e9 * seconds /
+		((double) frames * kBenchSubsteps * (double) helices * (double) particles);
+	printf("%u helices x %u particles, %u substeps: %.1f ms per frame, "
+		"%.2f ns per particle substep\n",
+		helices, particles, kBenchSubsteps, perFrame, perParticle);
+	return 0;
+}
@@ -0,0 +1,314 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixSpringSim.cpp
+//
+// Description:
+//     A dependency node that simulates helix curves as springs. See
+//     helixSpringSim.h.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+
+#include <maya/MPlug.h>
+#include <maya/MDataBlock.h>
+#include <maya/MDataHandle.h>
+#include <maya/MArrayDataHandle.h>
+#include <maya/MArrayDataBuilder.h>
+#include <maya/MFnNumericAttribute.h>
+#include <maya/MFnTypedAttribute.h>
+#include <maya/MFnUnitAttribute.h>
+#include <maya/MFnNurbsCurve.h>
+#include <maya/MFnNurbsCurveData.h>
+#include <maya/MPoint.h>
+#include <maya/MPointArray.h>
+
+#include "helixSpringSim.h"
+#include "helixGeometry.h"
+
+// Largest RMS distance of the CVs from the fit, over the radius, for
+// a curve to be simulated. As for helixFit.
+#define kFitTolerance	1.0e-3
+
+const MTypeId helixSpringSim::id( kHelixSpringSimId );
+const MString helixSpringSim::typeName( "helixSpringSim" );
+
+MObject helixSpringSim::inputCurves;
+MObject helixSpringSim::currentTime;
+MObject helixSpringSim::startTime;
+MObject helixSpringSim::stiffness;
+MObject helixSpringSim::damping;
+MObject helixSpringSim::drag;
+MObject helixSpringSim::mass;
+MObject helixSpringSim::gravity;
+MObject helixSpringSim::substeps;
+MObject helixSpringSim::pinned;
+MObject helixSpringSim::outputCurves;
+
+helixSpringSim::helixSpringSim()
+{
+	fStarted = false;
+}
+
+helixSpringSim::~helixSpringSim() {}
+
+void* helixSpringSim::creator()
+{
+	return new helixSpringSim;
+}
+
+MStatus helixSpringSim::initialize()
+{
+	MStatus stat;
+	MFnNumericAttribute numAttr;
+	MFnTypedAttribute typedAttr;
+	MFnUnitAttribute unitAttr;
+
+	inputCurves = typedAttr.create("inputCurves", "ic", MFnData::kNurbsCurve, &stat);
+	typedAttr.setArray(true);
+	typedAttr.setDisconnectBehavior(MFnAttribute::kDelete);
+
+	currentTime = unitAttr.create("currentTime", "ct", MFnUnitAttribute::kTime, 0.0, &stat);
+
+	startTime = unitAttr.create("startTime", "stt", MTime(1.0, MTime::kFilm), &stat);
+
+	stiffness = numAttr.create("stiffness", "stf", MFnNumericData::kDouble, 100.0, &stat);
+	numAttr.setKeyable(true);
+	numAttr.setMin(0.0);
+
+	damping = numAttr.create("damping", "dmp", MFnNumericData::kDouble, 1.0, &stat);
+	numAttr.setKeyable(true);
+	numAttr.setMin(0.0);
+
+	drag = numAttr.create("drag", "drg", MFnNumericData::kDouble, 0.5, &stat);
+	numAttr.setKeyable(true);
+	numAttr.setMin(0.0);
+
+	mass = numAttr.create("mass", "m", MFnNumericData::kDouble, 1.0, &stat);
+	numAttr.setKeyable(true);
+	numAttr.setMin(0.001);
+
+	gravity = numAttr.create("gravity", "grv", MFnNumericData::k3Double, 0.0, &stat);
+	numAttr.setDefault(0.0, -9.8, 0.0);
+	numAttr.setKeyable(true);
+
+	substeps = numAttr.create("substeps", "sub", MFnNumericData::kInt, 4, &stat);
+	numAttr.setKeyable(true);
+	numAttr.setMin(1);
+
+	pinned = numAttr.create("pinned", "pin", MFnNumericData::kInt, 2, &stat);
+	numAttr.setKeyable(true);
+	numAttr.setMin(0);
+
+	outputCurves = typedAttr.create("outputCurves", "oc", MFnData::kNurbsCurve, &stat);
+	typedAttr.setArray(true);
+	typedAttr.setUsesArrayDataBuilder(true);
+	typedAttr.setWritable(false);
+	typedAttr.setStorable(false);
+
+	MObject* inputs[] = { &inputCurves, &currentTime, &startTime, &stiffness,
+		&damping, &drag, &mass, &gravity, &substeps, &pinned };
+	for (unsigned i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+		stat = addAttribute(*inputs[i]);
+		if (!stat) {
+			stat.perror("addAttribute");
+			return stat;
+		}
+	}
+	stat = addAttribute(outputCurves);
+	if (!stat) {
+		stat.perror("addAttribute outputCurves");
+		return stat;
+	}
+
+	for (unsigned i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+		stat = attributeAffects(*inputs[i], outputCurves);
+		if (!stat) {
+			stat.perror("attributeAffects");
+			return stat;
+		}
+	}
+
+	return MS::kSuccess;
+}
+
+MStatus helixSpringSim::compute(const MPlug& plug, MDataBlock& data)
+	//
+	// Description
+	//     Brings the solver to the current time, resetting it first
+	//     at or before the start and when time has gone back, then
+	//     writes every output curve.
+	//
+{
+	MStatus stat;
+
+	if (plug != outputCurves && !(plug.isElement() && plug.array() == outputCurves))
+		return MS::kUnknownParameter;
+
+	const MTime now = data.inputValue(currentTime).asTime();
+	const MTime start = data.inputValue(startTime).asTime();
+
+	if (!fStarted || now <= start || now < fLastTime) {
+		stat = reset(data);
+		if (!stat)
+			return stat;
+		fLastTime = start;
+	}
+
+	if (now > fLastTime) {
+		helixSpringSettings settings;
+		settings.stiffness = data.inputValue(stiffness).asDouble();
+		settings.damping = data.inputValue(damping).asDouble();
+		settings.drag = data.inputValue(drag).asDouble();
+		settings.mass = data.inputValue(mass).asDouble();
+		const double3& g = data.inputValue(gravity).asDouble3();
+		settings.gravity[0] = g[0];
+		settings.gravity[1] = g[1];
+		settings.gravity[2] = g[2];
+		int count = data.inputValue(pinned).asInt();
+		settings.pinned = (count > 0) ? (unsigned) count : 0;
+		count = data.inputValue(substeps).asInt();
+		const unsigned steps = (count > 1) ? (unsigned) count : 1;
+
+		const double frame = MTime(1.0, MTime::uiUnit()).as(MTime::kSeconds);
+		const double elapsed = (now - fLastTime).as(MTime::kSeconds);
+		unsigned frames = (unsigned) ceil(elapsed / frame - 1.0e-6);
+		if (frames < 1)
+			frames = 1;
+		for (unsigned f = 0; f < frames; f++)
+			fSolver.step(settings, elapsed / (double) frames, steps);
+		fLastTime = now;
+	}
+
+	return writeCurves(data);
+}
+
+MStatus helixSpringSim::reset(MDataBlock& data)
+	//
+	// Description
+	//     Reads every input curve and fits them all at once, then seeds
+	//     the solver with the CVs of those that are helices.
+	//
+{
+	MStatus stat;
+	MArrayDataHandle inputs = data.inputArrayValue(inputCurves, &stat);
+	if (!stat)
+		return stat;
+
+	fSolver.clear();
+	fIndices.clear();
+	fHelices.clear();
+	fInputs.clear();
+	fKnots.clear();
+	fDegrees.clear();
+	fForms.clear();
+
+	std::vector<double> cvs;
+	std::vector<unsigned> offsets(1, 0);
+	const unsigned elements = inputs.elementCount();
+	for (unsigned e = 0; e < elements; e++, inputs.next()) {
+		MObject curveData = inputs.inputValue().asNurbsCurve();
+		MFnNurbsCurve curveFn(curveData, &stat);
+		MPointArray points;
+		MDoubleArray knots;
+		if (stat) {
+			curveFn.getCVs(points);
+			curveFn.getKnots(knots);
+		}
+
+		fIndices.append((int) inputs.elementIndex());
+		fInputs.append(curveData);
+		fKnots.push_back(knots);
+		fDegrees.append(stat ? curveFn.degree() : 0);
+		fForms.append(stat ? (int) curveFn.form() : (int) MFnNurbsCurve::kOpen);
+
+		for (unsigned i = 0; i < points.length(); i++) {
+			cvs.push_back(points[i].x);
+			cvs.push_back(points[i].y);
+			cvs.push_back(points[i].z);
+		}
+		offsets.push_back((unsigned) (cvs.size() / 3));
+	}
+
+	const unsigned curves = fIndices.length();
+	std::vector<helixFit> fits(curves);
+	if (!cvs.empty())
+		helixFitBatch((const double (*)[3]) &cvs[0], &offsets[0], curves, &fits[0]);
+
+	int helices = 0;
+	for (unsigned c = 0; c < curves; c++) {
+		const helixFit& fit = fits[c];
+		const unsigned count = offsets[c + 1] - offsets[c];
+		if (cvs.empty() || !fit.fitted || fit.residual > kFitTolerance * fit.radius ||
+			fDegrees[c] != 3) {
+			fHelices.append(-1);
+			continue;
+		}
+
+		double rest[kHelixSpringKinds];
+		helixSpringRestLengths(fit.cvRadius, fit.turn, fit.rise, rest);
+		fSolver.addHelix((const double (*)[3]) &cvs[3 * (size_t) offsets[c]], count, rest);
+		fHelices.append(helices++);
+	}
+
+	fStarted = true;
+	return MS::kSuccess;
+}
+
+MStatus helixSpringSim::writeCurves(MDataBlock& data)
+{
+	MStatus stat;
+	MArrayDataHandle outputs = data.outputArrayValue(outputCurves, &stat);
+	if (!stat)
+		return stat;
+	MArrayDataBuilder builder(&data, outputCurves, fIndices.length(), &stat);
+	if (!stat)
+		return stat;
+
+	std::vector<double> positions;
+	for (unsigned c = 0; c < fIndices.length(); c++) {
+		MDataHandle element = builder.addElement((unsigned) fIndices[c], &stat);
+		if (!stat)
+			return stat;
+		if (fHelices[c] < 0) {
+			element.set(fInputs[c]);
+			continue;
+		}
+
+		const unsigned helix = (unsigned) fHelices[c];
+		const unsigned count = fSolver.particleCount(helix);
+		positions.resize(3 * (size_t) count);
+		fSolver.getPositions(helix, (double (*)[3]) &positions[0]);
+		MPointArray points(count);
+		for (unsigned i = 0; i < count; i++)
+			points[i] = MPoint(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]);
+
+		MFnNurbsCurveData dataCreator;
+		MObject curveData = dataCreator.create(&stat);
+		if (!stat)
+			return stat;
+		MFnNurbsCurve curveFn;
+		curveFn.create(points, fKnots[c], (unsigned) fDegrees[c],
+			(MFnNurbsCurve::Form) fForms[c], false, false, curveData, &stat);
+		if (!stat) {
+			stat.perror("helixSpringSim: creating curve");
+			return stat;
+		}
+		element.set(curveData);
+	}
+
+	outputs.set(builder);
+	outputs.setAllClean();
+	return MS::kSuccess;
+}
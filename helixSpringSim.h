@@ -0,0 +1,96 @@
+#ifndef _helixSpringSim
+#define _helixSpringSim
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixSpringSim.h
+//
+// Description:
+//     A dependency node that simulates helix curves as springs.
+//
+//     Connect helix curves to inputCurves and time1.outTime to
+//     currentTime; outputCurves then holds the curves as simulated,
+//     for the shapes to be drawn from:
+//
+//         connectAttr helixShape1.worldSpace[0] helixSpringSim1.inputCurves[0];
+//         connectAttr time1.outTime helixSpringSim1.currentTime;
+//         connectAttr helixSpringSim1.outputCurves[0] simShape1.create;
+//
+//     Up to startTime the particles are the input curves' CVs, read
+//     afresh. The radius and pitch fitted to each curve by
+//     helixFitBatch() give its springs' rest lengths; curves that are
+//     not helices are passed through. Moving forward steps every helix
+//     at once with helixSpringSolver, one step per frame of the
+//     scene's time unit, split into substeps. Going back starts again
+//     from startTime.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <maya/MPxNode.h>
+#include <maya/MTypeId.h>
+#include <maya/MString.h>
+#include <maya/MTime.h>
+#include <maya/MObjectArray.h>
+#include <maya/MDoubleArray.h>
+#include <maya/MIntArray.h>
+
+#include <vector>
+
+#include "helixSpringSolver.h"
+
+#define kHelixSpringSimId		0x00081444
+
+class helixSpringSim : public MPxNode
+{
+public:
+					helixSpringSim();
+	virtual			~helixSpringSim();
+	static void*	creator();
+	static MStatus	initialize();
+
+	virtual MStatus	compute(const MPlug& plug, MDataBlock& data);
+
+	static const MTypeId	id;
+	static const MString	typeName;
+
+	// Inputs
+	static MObject	inputCurves;
+	static MObject	currentTime;
+	static MObject	startTime;
+	static MObject	stiffness;
+	static MObject	damping;
+	static MObject	drag;
+	static MObject	mass;
+	static MObject	gravity;
+	static MObject	substeps;
+	static MObject	pinned;
+
+	// Output
+	static MObject	outputCurves;
+
+private:
+	MStatus			reset(MDataBlock& data);
+	MStatus			writeCurves(MDataBlock& data);
+
+	helixSpringSolver	fSolver;
+	bool			fStarted;		// The solver holds the inputs' state
+	MTime			fLastTime;		// Time the solver is at
+	MIntArray		fIndices;		// Logical index of each input curve
+	MIntArray		fHelices;		// Each curve's helix in the solver, or -1
+	MObjectArray	fInputs;		// Each curve's data, for pass through
+	std::vector<MDoubleArray> fKnots;	// Each curve's knots
+	MIntArray		fDegrees;		// And degree
+	MIntArray		fForms;			// And form
+};
+
+#endif
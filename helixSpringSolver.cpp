@@ -0,0 +1,247 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixSpringSolver.cpp
+//
+// Description:
+//     A mass-spring solver for many helices at once. See
+//     helixSpringSolver.h.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+
+// HELIX_SPRING_SERIAL builds the solver without Maya, stepping every
+// helix on the calling thread, for helixSpringBench.
+#ifndef HELIX_SPRING_SERIAL
+#include <maya/MThreadPool.h>
+#endif
+
+#include "helixSpringSolver.h"
+
+// Helices per thread pool task.
+static const unsigned kSpringHelicesPerTask = 64;
+
+const unsigned helixSpringSolver::springOffsets[kHelixSpringKinds] = { 1, 2, 6 };
+
+void helixSpringRestLengths(double cvRadius, double turn, double rise,
+	double rest[kHelixSpringKinds])
+{
+	for (unsigned k = 0; k < kHelixSpringKinds; k++) {
+		const double span = (double) helixSpringSolver::springOffsets[k];
+		rest[k] = sqrt(2.0 * cvRadius * cvRadius * (1.0 - cos(span * turn)) +
+			span * span * rise * rise);
+	}
+}
+
+helixSpringSolver::helixSpringSolver()
+{
+	fOffsets.push_back(0);
+	fLongest = 0;
+}
+
+void helixSpringSolver::clear()
+{
+	fX.clear();
+	fY.clear();
+	fZ.clear();
+	fVX.clear();
+	fVY.clear();
+	fVZ.clear();
+	fOffsets.assign(1, 0);
+	fRest.clear();
+	fLongest = 0;
+}
+
+void helixSpringSolver::addHelix(const double (*cvs)[3], unsigned count,
+	const double rest[kHelixSpringKinds])
+{
+	for (unsigned i = 0; i < count; i++) {
+		fX.push_back(cvs[i][0]);
+		fY.push_back(cvs[i][1]);
+		fZ.push_back(cvs[i][2]);
+	}
+	fVX.resize(fX.size(), 0.0);
+	fVY.resize(fX.size(), 0.0);
+	fVZ.resize(fX.size(), 0.0);
+	fOffsets.push_back((unsigned) fX.size());
+	fRest.insert(fRest.end(), rest, rest + kHelixSpringKinds);
+	if (count > fLongest)
+		fLongest = count;
+}
+
+unsigned helixSpringSolver::helixCount() const
+{
+	return (unsigned) fOffsets.size() - 1;
+}
+
+unsigned helixSpringSolver::particleCount(unsigned helix) const
+{
+	return fOffsets[helix + 1] - fOffsets[helix];
+}
+
+void helixSpringSolver::getPositions(unsigned helix, double (*out)[3]) const
+{
+	const unsigned first = fOffsets[helix];
+	const unsigned count = fOffsets[helix + 1] - first;
+	for (unsigned i = 0; i < count; i++) {
+		out[i][0] = fX[first + i];
+		out[i][1] = fY[first + i];
+		out[i][2] = fZ[first + i];
+	}
+}
+
+void helixSpringSolver::stepHelix(unsigned helix,
+	const helixSpringSettings& settings, double dt, unsigned substeps,
+	double* scratch)
+	//
+	// Description
+	//     Each kind of spring is done in three passes over the helix
+	//     rather than one: the force per unit length of every spring,
+	//     then its push on the near particles, then on the far ones.
+	//     A single pass would write each particle twice a few
+	//     iterations apart, which keeps the compiler from vectorizing.
+	//
+{
+	const unsigned first = fOffsets[helix];
+	const unsigned n = fOffsets[helix + 1] - first;
+	double* x = &fX[first];
+	double* y = &fY[first];
+	double* z = &fZ[first];
+	double* vx = &fVX[first];
+	double* vy = &fVY[first];
+	double* vz = &fVZ[first];
+	const double* rest = &fRest[kHelixSpringKinds * helix];
+
+	double* fx = scratch;
+	double* fy = fx + n;
+	double* fz = fy + n;
+	double* tension = fz + n;
+
+	const double invMass = (settings.mass > 0.0) ? 1.0 / settings.mass : 0.0;
+	double keep = 1.0 - settings.drag * dt;
+	if (keep < 0.0)
+		keep = 0.0;
+	const unsigned pinned = (settings.pinned < n) ? settings.pinned : n;
+
+	for (unsigned s = 0; s < substeps; s++) {
+		for (unsigned i = 0; i < n; i++)
+			fx[i] = fy[i] = fz[i] = 0.0;
+
+		for (unsigned k = 0; k < kHelixSpringKinds; k++) {
+			const unsigned o = springOffsets[k];
+			if (o >= n)
+				continue;
+			const unsigned springs = n - o;
+			const double length = rest[k];
+
+			for (unsigned i = 0; i < springs; i++) {
+				const double dx = x[i + o] - x[i];
+				const double dy = y[i + o] - y[i];
+				const double dz = z[i + o] - z[i];
+				const double dvx = vx[i + o] - vx[i];
+				const double dvy = vy[i + o] - vy[i];
+				const double dvz = vz[i + o] - vz[i];
+				const double len2 = dx * dx + dy * dy + dz * dz;
+				const double len = sqrt(len2);
+				const double invLen = (len > 0.0) ? 1.0 / len : 0.0;
+				tension[i] = (settings.stiffness * (len - length) +
+					settings.damping * (dx * dvx + dy * dvy + dz * dvz) * invLen) * invLen;
+			}
+			for (unsigned i = 0; i < springs; i++) {
+				fx[i] += tension[i] * (x[i + o] - x[i]);
+				fy[i] += tension[i] * (y[i + o] - y[i]);
+				fz[i] += tension[i] * (z[i + o] - z[i]);
+			}
+			for (unsigned i = 0; i < springs; i++) {
+				fx[i + o] -= tension[i] * (x[i + o] - x[i]);
+				fy[i + o] -= tension[i] * (y[i + o] - y[i]);
+				fz[i + o] -= tension[i] * (z[i + o] - z[i]);
+			}
+		}
+
+		for (unsigned i = pinned; i < n; i++) {
+			vx[i] = (vx[i] + dt * (fx[i] * invMass + settings.gravity[0])) * keep;
+			vy[i] = (vy[i] + dt * (fy[i] * invMass + settings.gravity[1])) * keep;
+			vz[i] = (vz[i] + dt * (fz[i] * invMass + settings.gravity[2])) * keep;
+			x[i] += dt * vx[i];
+			y[i] += dt * vy[i];
+			z[i] += dt * vz[i];
+		}
+	}
+}
+
+void helixSpringSolver::stepHelices(unsigned first, unsigned end,
+	const helixSpringSettings& settings, double dt, unsigned substeps)
+{
+	std::vector<double> scratch(4 * (size_t) fLongest);
+	for (unsigned h = first; h < end; h++)
+		stepHelix(h, settings, dt, substeps, &scratch[0]);
+}
+
+#ifndef HELIX_SPRING_SERIAL
+struct helixSpringTask
+{
+	helixSpringSolver*	solver;
+	const helixSpringSettings* settings;
+	double				dt;
+	unsigned			substeps;
+	unsigned			first;
+	unsigned			end;
+};
+
+static MThreadRetVal springTaskFunc(void* data)
+{
+	helixSpringTask* task = (helixSpringTask*) data;
+	task->solver->stepHelices(task->first, task->end, *task->settings,
+		task->dt, task->substeps);
+	return 0;
+}
+
+static void springDecompose(void* data, MThreadRootTask* root)
+{
+	std::vector<helixSpringTask>* tasks = (std::vector<helixSpringTask>*) data;
+	for (size_t i = 0; i < tasks->size(); i++)
+		MThreadPool::createTask(springTaskFunc, (void*) &(*tasks)[i], root);
+	MThreadPool::executeAndJoin(root);
+}
+#endif
+
+void helixSpringSolver::step(const helixSpringSettings& settings,
+	double time, unsigned substeps)
+{
+	const unsigned helices = helixCount();
+	if (helices == 0 || substeps == 0 || fLongest == 0)
+		return;
+
+#ifdef HELIX_SPRING_SERIAL
+	stepHelices(0, helices, settings, time / (double) substeps, substeps);
+#else
+	std::vector<helixSpringTask> tasks;
+	for (unsigned first = 0; first < helices; first += kSpringHelicesPerTask) {
+		helixSpringTask task;
+		task.solver = this;
+		task.settings = &settings;
+		task.dt = time / (double) substeps;
+		task.substeps = substeps;
+		task.first = first;
+		task.end = (helices - first < kSpringHelicesPerTask) ? helices : first + kSpringHelicesPerTask;
+		tasks.push_back(task);
+	}
+
+	if (tasks.size() < 2 || !MThreadPool::newParallelRegion(springDecompose, (void*) &tasks)) {
+		for (size_t i = 0; i < tasks.size(); i++)
+			springTaskFunc(&tasks[i]);
+	}
+#endif
+}
@@ -0,0 +1,101 @@
+#ifndef _helixSpringSolver
+#define _helixSpringSolver
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixSpringSolver.h
+//
+// Description:
+//     A mass-spring solver for many helices at once.
+//
+//     Each helix is a chain of particles, one per CV, joined by
+//     springs to the particles one, two and six CVs further on: along
+//     the wire, across each bend, and roughly one coil up, which
+//     holds the coil spacing. On an undeformed helix every spring of
+//     a kind has the same length, found from the CV radius, turn and
+//     rise per CV alone, so a helix carries three rest lengths rather
+//     than one per spring.
+//
+//     Positions and velocities are held as separate x, y and z arrays
+//     (structure of arrays) with each helix contiguous, so the inner
+//     loops run over plain arrays the compiler can vectorize. Helices
+//     do not interact, so they are stepped in parallel on Maya's
+//     thread pool, each taking all its substeps while it is in cache.
+//
+//     Integration is semi-implicit Euler: velocities are updated from
+//     the forces, then positions from the new velocities.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+// Spring kinds: CV offsets of the particles each joins.
+#define kHelixSpringKinds		3
+
+struct helixSpringSettings
+{
+	double			stiffness;		// Force per unit stretch
+	double			damping;		// Force per unit stretching speed
+	double			drag;			// Fraction of velocity lost per second
+	double			mass;			// Of each particle
+	double			gravity[3];
+	unsigned		pinned;			// Particles held still at each helix's start
+};
+
+class helixSpringSolver
+{
+public:
+					helixSpringSolver();
+
+	void			clear();
+
+	// Adds a helix of count particles at cvs, at rest with springs of
+	// the rest lengths of helixSpringRestLengths().
+	void			addHelix(const double (*cvs)[3], unsigned count,
+						const double rest[kHelixSpringKinds]);
+
+	// Advances every helix by time, in substeps equal steps.
+	void			step(const helixSpringSettings& settings,
+						double time, unsigned substeps);
+
+	unsigned		helixCount() const;
+	unsigned		particleCount(unsigned helix) const;
+	void			getPositions(unsigned helix, double (*out)[3]) const;
+
+	// CV offsets of the particles joined by each kind of spring.
+	static const unsigned	springOffsets[kHelixSpringKinds];
+
+	// Steps the helices from first up to end; for the thread pool.
+	void			stepHelices(unsigned first, unsigned end,
+						const helixSpringSettings& settings,
+						double dt, unsigned substeps);
+
+private:
+	void			stepHelix(unsigned helix, const helixSpringSettings& settings,
+						double dt, unsigned substeps, double* scratch);
+
+	std::vector<double>		fX, fY, fZ;
+	std::vector<double>		fVX, fVY, fVZ;
+	std::vector<unsigned>	fOffsets;	// First particle of each helix, and the end
+	std::vector<double>		fRest;		// kHelixSpringKinds per helix
+	unsigned				fLongest;	// Most particles in a helix
+};
+
+// Rest lengths of the springs of an undeformed helix of the given CV
+// radius, turn in radians per CV and rise per CV: a chord spanning
+// k turns and k rises.
+//
+void helixSpringRestLengths(double cvRadius, double turn, double rise,
+	double rest[kHelixSpringKinds]);
+
+#endif
@@ -0,0 +1,131 @@
+//-
+// ==========================================================================
+// Copyright 2015 Autodesk, Inc.  All rights reserved.
+//
+// Use of this software is subject to the terms of the Autodesk
+// license agreement provided at the time of installation or download,
+// or which otherwise accompanies this software in either electronic
+// or hard copy form.
+// ==========================================================================
+//+
+
+////////////////////////////////////////////////////////////////////////
+//
+// helixStrandsBench.cpp
+//
+// Description:
+//     A headless benchmark of the CVs behind helixToolCmd -strands:
+//     the strands of a helix are built by one helixStrandCVs call,
+//     then again as independent helices, one per strand, each with
+//     its own cos and sin per CV as separate helixToolCmd calls
+//     would compute them. Both must give the same CVs. It is not
+//     part of the plug-in, and needs no running Maya, only the
+//     libraries helixGeometry links against:
+//
+//         c++ -O2 -I$MAYA_LOCATION/include helixStrandsBench.cpp
+//             helixGeometry.cpp -L$MAYA_LOCATION/lib -lOpenMaya
+//             -lFoundation -o helixStrandsBench
+//
+//     Usage:
+//
+//         helixStrandsBench [CVs [repeats]]
+//
+//     For 2, 3, 4 and 8 strands of CVs each, the fastest of repeats
+//     builds is reported both ways.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <vector>
+
+#include "helixGeometry.h"
+
+#define kBenchCVs			1000000
+#define kBenchRepeats		5
+#define kBenchRadius		4.0
+#define kBenchRise			0.08
+#define kCompareTolerance	1.0e-9
+
+static double seconds(clock_t start)
+{
+	return (double) (clock() - start) / (double) CLOCKS_PER_SEC;
+}
+
+static void independentStrands(double radius, double rise, unsigned numCVs,
+	unsigned strands, double (*cvs)[4])
+	//
+	// Description
+	//     Each strand built as a helix of its own, turned by its
+	//     phase: the CVs of helixProfileCVs with the phase added to
+	//     every angle, so the trig is done once per CV per strand.
+	//
+{
+	for (unsigned k = 0; k < strands; k++) {
+		const double phase = 2.0 * 3.14159265358979 * (double) k / (double) strands;
+		double (*strand)[4] = cvs + (size_t) k * numCVs;
+
+		for (unsigned i = 0; i < numCVs; i++) {
+			strand[i][0] = radius * cos((double) i + phase);
+			strand[i][1] = rise * (double) i;
+			strand[i][2] = radius * sin((double) i + phase);
+			strand[i][3] = 1.0;
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const unsigned numCVs = (argc > 1) ? (unsigned) atoi(argv[1]) : kBenchCVs;
+	const unsigned repeats = (argc > 2) ? (unsigned) atoi(argv[2]) : kBenchRepeats;
+	if (numCVs < 4 || repeats == 0) {
+		fprintf(stderr, "usage: %s [CVs [repeats]]\n", argv[0]);
+		return 1;
+	}
+
+	const unsigned strandCounts[] = { 2, 3, 4, 8 };
+	bool same = true;
+	for (unsigned s = 0; s < sizeof(strandCounts) / sizeof(strandCounts[0]); s++) {
+		const unsigned strands = strandCounts[s];
+		std::vector<double> shared(4 * (size_t) numCVs * strands);
+		std::vector<double> independent(shared.size());
+
+		double sharedTime = 0.0, independentTime = 0.0;
+		for (unsigned r = 0; r < repeats; r++) {
+			clock_t start = clock();
+			helixStrandCVs(kBenchRadius, kBenchRadius, kBenchRise, NULL,
+				numCVs, strands, (double (*)[4]) &shared[0]);
+			const double t = seconds(start);
+			if (r == 0 || t < sharedTime)
+				sharedTime = t;
+
+			start = clock();
+			independentStrands(kBenchRadius, kBenchRise, numCVs, strands,
+				(double (*)[4]) &independent[0]);
+			const double e = seconds(start);
+			if (r == 0 || e < independentTime)
+				independentTime = e;
+		}
+
+		// The rotation rounds differently from a cos and sin of the
+		// summed angle, so the CVs agree to a tolerance, not bit for bit.
+		double worst = 0.0;
+		for (size_t j = 0; j < shared.size(); j++) {
+			const double d = fabs(shared[j] - independent[j]);
+			if (d > worst)
+				worst = d;
+		}
+		const bool match = worst <= kCompareTolerance * kBenchRadius;
+		same = same && match;
+
+		printf("%u strands of %u CVs: one pass %.2f ms, independent %.2f ms, "
+			"%.2fx, largest difference %g%s\n", strands, numCVs,
+			1000.0 * sharedTime, 1000.0 * independentTime,
+			sharedTime > 0.0 ? independentTime / sharedTime : 0.0, worst,
+			match ? "" : ", CVS DIFFER");
+	}
+	return same ? 0 : 1;
+}
@@ -46,7 +46,18 @@
 #include <maya/MPoint.h>
 #include <maya/MPointArray.h>
 #include <maya/MDoubleArray.h>
+#include <maya/MIntArray.h>
+#include <maya/MFloatArray.h>
+#include <maya/MRampAttribute.h>
 #include <maya/MDagPath.h>
+#include <maya/MObjectArray.h>
+#include <maya/MObjectHandle.h>
+#include <maya/MDagModifier.h>
+#include <maya/MMatrix.h>
+#include <maya/MTransformationMatrix.h>
+#include <maya/MEulerRotation.h>
+#include <maya/MSelectionList.h>
+#include <maya/MItSelectionList.h>
 
 #include <maya/MPxContext.h>
 #include <maya/MPxContextCommand.h>
@@ -54,16 +65,54 @@
 #include <maya/MToolsInfo.h>
 
 #include <maya/MFnPlugin.h>
+#include <maya/MThreadPool.h>
+#include <maya/MThreadAsync.h>
+#include <maya/MAtomic.h>
+#include <maya/MEventMessage.h>
+#include <maya/MDrawRegistry.h>
 #include <maya/MFnNurbsCurve.h> 
+#include <maya/MFnTransform.h>
+#include <maya/MFnMesh.h>
+#include <maya/MFnPluginData.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MPlug.h>
+#include <maya/MFnSet.h>
+#include <maya/MFloatPointArray.h>
+#include <maya/MVectorArray.h>
 
 #include <maya/MSyntax.h>
 #include <maya/MArgParser.h>
 #include <maya/MArgDatabase.h>
 #include <maya/MCursor.h>
+#include <maya/MComputation.h>
+#include <maya/MTimer.h>
 
 #include <maya/MGL.h>
 #include <maya/MUIDrawManager.h>
 
+#include <vector>
+#include <string>
+#include <stdlib.h>
+#include <float.h>
+
+#ifdef _WIN32
+#include <windows.h>		// Sleep
+#else
+#include <unistd.h>			// usleep
+#endif
+
+#include "helixIO.h"
+#include "helixGeometry.h"
+#include "helixCloudShape.h"
+#include "helixCloudGeometryOverride.h"
+#include "helixNode.h"
+#include "helixInstancer.h"
+#include "helixSpringSim.h"
+#include "helixCompress.h"
+#include "helixArena.h"
+#include "helixFitCmd.h"
+#include "helixQueryCmd.h"
+
 #define PI 3.1415926
 
 #define kPitchFlag			"-p"
@@ -74,6 +123,42 @@
 #define kNumberCVsFlagLong	"-numCVs"
 #define kUpsideDownFlag		"-ud"
 #define kUpsideDownFlagLong	"-upsideDown"
+#define kPackedFlag			"-pk"
+#define kPackedFlagLong		"-packed"
+#define kEchoFlag			"-ec"
+#define kEchoFlagLong		"-echo"
+#define kImportFileFlag		"-if"
+#define kImportFileFlagLong	"-importFile"
+#define kExportFileFlag		"-ef"
+#define kExportFileFlagLong	"-exportFile"
+#define kMeshFlag			"-msh"
+#define kMeshFlagLong		"-mesh"
+#define kTubeRadiusFlag		"-tr"
+#define kTubeRadiusFlagLong	"-tubeRadius"
+#define kTubeSidesFlag		"-tsd"
+#define kTubeSidesFlagLong	"-tubeSides"
+#define kTubeSegmentsFlag	"-tsg"
+#define kTubeSegmentsFlagLong "-tubeSegments"
+#define kCloudFlag			"-cl"
+#define kCloudFlagLong		"-cloud"
+#define kProceduralFlag		"-pro"
+#define kProceduralFlagLong	"-procedural"
+#define kIncrementalFlag	"-inc"
+#define kIncrementalFlagLong "-incremental"
+#define kArenaStatsFlag		"-as"
+#define kArenaStatsFlagLong	"-arenaStats"
+#define kPathFlag			"-pth"
+#define kPathFlagLong		"-path"
+#define kEndRadiusFlag		"-er"
+#define kEndRadiusFlagLong	"-endRadius"
+#define kPitchRampFlag		"-pr"
+#define kPitchRampFlagLong	"-pitchRamp"
+#define kStrandsFlag		"-st"
+#define kStrandsFlagLong	"-strands"
+#define kCombineFlag		"-cmb"
+#define kCombineFlagLong	"-combine"
+#define kJointsFlag			"-jnt"
+#define kJointsFlagLong		"-joints"
 
 /////////////////////////////////////////////////////////////
 // The users tool command
@@ -81,6 +166,54 @@
 
 #define		NUMBER_OF_CVS		20
 
+// Long commands show a progress bar and can be interrupted with Esc.
+// Interruption is checked every kProgressChunk helices, between one
+// helix and the next.
+//
+#define		kProgressChunk		256
+
+// Time an incremental command spends creating helices per idle event.
+#define		kIncrementalSlice	0.008
+
+// Path samples for coiling: per span of the path curve, and at least.
+#define		kPathSamplesPerSpan	32
+#define		kMinPathSamples		256
+#define		kMaxCachedPaths		16
+
+// Most strands per helix. The CVs of all of a helix's strands are
+// built at once, so this bounds that buffer.
+#define		kMaxStrands			64
+
+// Parameters of a single helix. A helixTool instance holds one of
+// these per helix it creates, so that a whole batch of helices is
+// a single command (and a single undo record).
+//
+struct helixDesc
+{
+	helixDesc() : hasMatrix(false) {}
+
+	double			radius;
+	double			pitch;
+	unsigned		numCV;
+	bool			upDown;
+	bool			hasMatrix;		// Place the helix with matrix
+	MMatrix			matrix;
+};
+
+// The nodes a command has created, for undo to delete. An incremental
+// command shares them with the helixTool populating for it, which may
+// outlive it, so they are freed with the last of the two.
+//
+struct helixCreatedNodes
+{
+	helixCreatedNodes() : refs(1) {}
+
+	MObjectArray	transforms;		// Above each helix
+	MObjectArray	historyNodes;	// helixNodes driving procedural curves
+	MObjectArray	jointRoots;		// Joint chains along the helices
+	unsigned		refs;			// helixTools holding these
+};
+
 class helixTool : public MPxToolCommand
 {
 public:
@@ -100,28 +233,151 @@ public:
 	void			setPitch(double newPitch);
 	void			setNumCVs(unsigned newNumCVs);
 	void			setUpsideDown(bool newUpsideDown);
+	void			setEcho(bool newEcho);
+	void			setProfile(const double (*cvs)[4]);
+	static void		clearPopulateQueue();
 
 private:
+	MStatus			parsePacked(const MString& packed);
+	MStatus			parsePitchRamp();
+	MString			packedString() const;
+	MString			journalString() const;
+	unsigned		helixCount() const;
+	helixDesc		helixAt(unsigned index) const;
+	MStatus			beginHelices();
+	MStatus			nextHelix(helixDesc& desc, bool& done);
+	void			endHelices();
+	MStatus			checkHelices();
+	MStatus			createHelix(const helixDesc& desc, MObject& transform);
+	MStatus			deleteHelices();
+	MStatus			exportHelices();
+	MStatus			createSpring(const helixDesc& desc, MObject& transform);
+	MStatus			createProceduralHelix(const helixDesc& desc, MObject& transform);
+	MStatus			createCoil(const helixDesc& desc, MObject& transform);
+	MStatus			createStrands(const helixDesc& desc, MObject& transform);
+	MStatus			shadeSprings();
+	MStatus			createJoints();
+	MStatus			findCloud(MObject& shape) const;
+	MStatus			addToCloud();
+	MStatus			truncateCloud();
+	void			beginProgress();
+	MStatus			queuePopulation();
+	void			cancelPopulation();
+	static void		populateIdle(void* clientData);
+	bool			populateSlice();
+	bool			progressInterrupted(unsigned created);
+	void			endProgress();
+
 	double			radius;     	// Helix radius
 	double			pitch;      	// Helix pitch
 	unsigned		numCV;			// Helix number of CVs
 	bool			upDown;			// Helix upsideDown
-	MDagPath		path;			// The dag path to the curve.
+	bool			echo;			// Journal the command
+	std::vector<helixDesc> batch;	// Per-helix values when invoked with
+									// multi-use flags, empty otherwise
+	MString			importPath;		// Helix file to create from
+	bool			importText;		// importPath is CSV or JSON
+	helixBinaryReader binaryFile;	// Mapped only while helices are read
+	helixTextReader	textFile;		// Mapped only while helices are read
+	MUint64			cursor;			// Next helix for nextHelix()
+	MString			exportPath;		// Binary helix file to write
+	MSelectionList	exportList;		// Curves to write to exportPath
+	bool			meshOutput;		// Build spring meshes, not curves
+	double			tubeRadius;		// Spring wire radius
+	unsigned		tubeSides;		// Faces around the spring wire
+	unsigned		tubeSegments;	// Faces along the wire per CV span
+	MSelectionList	springShapes;	// Meshes waiting for a shading group
+	bool			procedural;		// Drive curves from helixNodes
+	const double	(*profileCVs)[4];	// Built by the tool context, or NULL
+	MString			cloudName;		// helixCloud shape to add helices to
+	unsigned		cloudCount;		// Helices in the cloud before redoIt
+	unsigned		createLimit;	// Helices redoIt may create; lowered
+									// when an import is interrupted
+	MComputation	computation;	// Progress and Esc for long commands
+	bool			showProgress;	// computation has begun
+	bool			interrupted;	// Esc was pressed during redoIt
+	bool			incremental;	// Create helices on idle, a slice at a time
+	MArgList		commandArgs;	// Parsed again by each populating helixTool
+	bool			queued;			// Populates for an incremental command
+	bool			arenaStats;		// Report on the last batch only
+	MString			pathName;		// Curve to coil the helices around
+	bool			tapered;		// Radius runs to endRadius
+	double			endRadius;		// Radius of the last CV when tapered
+	MString			pitchRamp;		// "position value ..." pitch scales
+	std::vector<double> rampPositions;	// Parsed from pitchRamp
+	std::vector<double> rampValues;
+	std::vector<float> pitchTable;	// pitchRamp baked; empty for none
+	unsigned		strands;		// Phase offset copies of each helix
+	bool			combine;		// Strands share one transform
+	unsigned		joints;			// Joints in a chain along each helix
+	MObjectArray	jointParents;	// Transforms waiting for a joint chain
+	std::vector<helixDesc> jointHelices;	// And the helices they hold
+	unsigned		helicesCreated;	// Helices made by redoIt so far
+	helixCreatedNodes* created;		// Nodes created by the last redoIt.
 	// Don't save the pointer!
+
+	// Incremental commands queue a helixTool of their own that creates
+	// their helices on idle, a slice at a time, in the order the
+	// commands ran. The plug-in owns the queue, not the commands.
+	static std::vector<helixTool*> populateQueue;
+	static MCallbackId populateCallback;
 };
 
+std::vector<helixTool*> helixTool::populateQueue;
+MCallbackId helixTool::populateCallback = 0;
+
+
+static bool isFinite(double value)
+{
+	return value == value && fabs(value) <= DBL_MAX;
+}
 
 void* helixTool::creator()
 {
 	return new helixTool;
 }
 
-helixTool::~helixTool() {}
+helixTool::~helixTool()
+	//
+	// Description
+	//     A command flushed from the undo queue while its helices are
+	//     still being made leaves them to its populating helixTool,
+	//     which keeps the created nodes until it is done.
+	//
+{
+	if (--created->refs == 0)
+		delete created;
+}
 
 helixTool::helixTool()
 {
+	radius = 4.0;
+	pitch = 0.5;
 	numCV = 20;
 	upDown = false;
+	echo = true;
+	importText = false;
+	cursor = 0;
+	meshOutput = false;
+	tubeRadius = 0.1;
+	tubeSides = 8;
+	tubeSegments = 4;
+	procedural = false;
+	profileCVs = NULL;
+	cloudCount = 0;
+	createLimit = ~0u;
+	showProgress = false;
+	interrupted = false;
+	incremental = false;
+	queued = false;
+	created = new helixCreatedNodes;
+	arenaStats = false;
+	tapered = false;
+	endRadius = 0.0;
+	strands = 1;
+	combine = false;
+	joints = 0;
+	helicesCreated = 0;
 	setCommandString("helixToolCmd");
 }
 
@@ -133,6 +389,35 @@ MSyntax helixTool::newSyntax()
 	syntax.addFlag(kRadiusFlag, kRadiusFlagLong, MSyntax::kDouble);
 	syntax.addFlag(kNumberCVsFlag, kNumberCVsFlagLong, MSyntax::kUnsigned);
 	syntax.addFlag(kUpsideDownFlag, kUpsideDownFlagLong, MSyntax::kBoolean);
+	syntax.addFlag(kPackedFlag, kPackedFlagLong, MSyntax::kString);
+	syntax.addFlag(kEchoFlag, kEchoFlagLong, MSyntax::kBoolean);
+	syntax.addFlag(kImportFileFlag, kImportFileFlagLong, MSyntax::kString);
+	syntax.addFlag(kExportFileFlag, kExportFileFlagLong, MSyntax::kString);
+	syntax.addFlag(kMeshFlag, kMeshFlagLong, MSyntax::kBoolean);
+	syntax.addFlag(kTubeRadiusFlag, kTubeRadiusFlagLong, MSyntax::kDouble);
+	syntax.addFlag(kTubeSidesFlag, kTubeSidesFlagLong, MSyntax::kUnsigned);
+	syntax.addFlag(kTubeSegmentsFlag, kTubeSegmentsFlagLong, MSyntax::kUnsigned);
+	syntax.addFlag(kCloudFlag, kCloudFlagLong, MSyntax::kString);
+	syntax.addFlag(kProceduralFlag, kProceduralFlagLong, MSyntax::kBoolean);
+	syntax.addFlag(kIncrementalFlag, kIncrementalFlagLong, MSyntax::kBoolean);
+	syntax.addFlag(kArenaStatsFlag, kArenaStatsFlagLong);
+	syntax.addFlag(kPathFlag, kPathFlagLong, MSyntax::kString);
+	syntax.addFlag(kEndRadiusFlag, kEndRadiusFlagLong, MSyntax::kDouble);
+	syntax.addFlag(kPitchRampFlag, kPitchRampFlagLong, MSyntax::kString);
+	syntax.addFlag(kStrandsFlag, kStrandsFlagLong, MSyntax::kUnsigned);
+	syntax.addFlag(kCombineFlag, kCombineFlagLong, MSyntax::kBoolean);
+	syntax.addFlag(kJointsFlag, kJointsFlagLong, MSyntax::kUnsigned);
+
+	// Curves to export; the selection is used when none are given.
+	syntax.setObjectType(MSyntax::kSelectionList, 0);
+
+	// Each use of a flag describes one more helix, so a whole batch
+	// can be created (and undone) by a single command.
+	//
+	syntax.makeFlagMultiUse(kPitchFlag);
+	syntax.makeFlagMultiUse(kRadiusFlag);
+	syntax.makeFlagMultiUse(kNumberCVsFlag);
+	syntax.makeFlagMultiUse(kUpsideDownFlag);
 
 	return syntax;
 }
@@ -150,127 +435,1864 @@ MStatus helixTool::doIt(const MArgList &args)
 
 	if (MS::kSuccess != status)
 		return status;
+	if (incremental)
+		commandArgs = args;
+
+	// A batch typed as one flag group per helix is journaled as a
+	// single packed string instead. With echo off the command stays
+	// out of the journal, but is still undoable.
+	//
+	if (!echo)
+		setHistoryOn(false);
+	else if (!batch.empty() && importPath.length() == 0)
+		setCommandString(journalString());
 
 	return redoIt();
 }
 
 MStatus helixTool::parseArgs(const MArgList &args)
+	//
+	// Description
+	//     Every flag may be used several times. The Nth use of a flag
+	//     applies to the Nth helix; a helix with no Nth use of a flag
+	//     takes the value from the last use of that flag.
+	//
 {
 	MStatus status;
-	MArgDatabase argData(syntax(), args);
+	// A populating helixTool is not made by Maya, so it has no syntax
+	// of its own.
+	MArgDatabase argData(queued ? newSyntax() : syntax(), args);
+
+	// Reports how the scratch buffers of the last batch were used,
+	// and creates nothing.
+	//
+	if (argData.isFlagSet(kArenaStatsFlag)) {
+		arenaStats = true;
+		return MS::kSuccess;
+	}
+
+	if (argData.isFlagSet(kEchoFlag)) {
+		status = argData.getFlagArgument(kEchoFlag, 0, echo);
+		if (!status) {
+			status.perror("echo flag parsing failed");
+			return status;
+		}
+	}
+
+	// Spring mesh settings apply to every helix of the command.
+	//
+	if (argData.isFlagSet(kMeshFlag)) {
+		status = argData.getFlagArgument(kMeshFlag, 0, meshOutput);
+		if (!status) {
+			status.perror("mesh flag parsing failed");
+			return status;
+		}
+	}
+
+	if (argData.isFlagSet(kTubeRadiusFlag)) {
+		status = argData.getFlagArgument(kTubeRadiusFlag, 0, tubeRadius);
+		if (!status || tubeRadius <= 0.0) {
+			MGlobal::displayError("tubeRadius must be greater than 0");
+			return MS::kInvalidParameter;
+		}
+	}
+
+	if (argData.isFlagSet(kTubeSidesFlag)) {
+		status = argData.getFlagArgument(kTubeSidesFlag, 0, tubeSides);
+		if (!status || tubeSides < 3) {
+			MGlobal::displayError("tubeSides must be at least 3");
+			return MS::kInvalidParameter;
+		}
+	}
+
+	if (argData.isFlagSet(kTubeSegmentsFlag)) {
+		status = argData.getFlagArgument(kTubeSegmentsFlag, 0, tubeSegments);
+		if (!status || tubeSegments < 1) {
+			MGlobal::displayError("tubeSegments must be at least 1");
+			return MS::kInvalidParameter;
+		}
+	}
+
+	// Procedural curves keep a helixNode as their history, so that
+	// scene files store four parameters per helix instead of CVs.
+	//
+	if (argData.isFlagSet(kProceduralFlag)) {
+		status = argData.getFlagArgument(kProceduralFlag, 0, procedural);
+		if (!status) {
+			status.perror("procedural flag parsing failed");
+			return status;
+		}
+		if (procedural && meshOutput) {
+			MGlobal::displayError("procedural helices cannot be meshes");
+			return MS::kInvalidParameter;
+		}
+	}
+
+	// Incremental commands return at once and create their helices
+	// on idle events, so a large import fills the scene while the
+	// viewport stays usable. Undo stops it wherever it has got to.
+	//
+	if (argData.isFlagSet(kIncrementalFlag)) {
+		status = argData.getFlagArgument(kIncrementalFlag, 0, incremental);
+		if (!status) {
+			status.perror("incremental flag parsing failed");
+			return status;
+		}
+	}
+
+	// Helices go into an existing helixCloud shape instead of
+	// becoming curves or meshes of their own.
+	//
+	if (argData.isFlagSet(kCloudFlag)) {
+		status = argData.getFlagArgument(kCloudFlag, 0, cloudName);
+		if (!status) {
+			status.perror("cloud flag parsing failed");
+			return status;
+		}
+		MObject shape;
+		status = findCloud(shape);
+		if (!status)
+			return status;
+	}
+
+	// Tapers and pitch ramps apply to every helix of the command.
+	// The ramp is baked into a table once here, so building each
+	// helix stays a single pass over its CVs.
+	//
+	if (argData.isFlagSet(kEndRadiusFlag)) {
+		status = argData.getFlagArgument(kEndRadiusFlag, 0, endRadius);
+		if (!status || !(endRadius >= 0.0)) {
+			MGlobal::displayError("endRadius must not be negative");
+			return MS::kInvalidParameter;
+		}
+		tapered = true;
+	}
+
+	if (argData.isFlagSet(kPitchRampFlag)) {
+		status = argData.getFlagArgument(kPitchRampFlag, 0, pitchRamp);
+		if (status)
+			status = parsePitchRamp();
+		if (!status)
+			return status;
+	}
+
+	if ((tapered || !pitchTable.empty()) &&
+		(meshOutput || cloudName.length() > 0 || argData.isFlagSet(kPathFlag))) {
+		MGlobal::displayError("endRadius and pitchRamp cannot be combined with mesh, cloud or path");
+		return MS::kInvalidParameter;
+	}
+
+	// Each helix becomes strands helices evenly spaced in phase, as
+	// for a double helix, either as separate curves or as curves
+	// under one transform.
+	//
+	if (argData.isFlagSet(kStrandsFlag)) {
+		status = argData.getFlagArgument(kStrandsFlag, 0, strands);
+		if (!status || strands < 1 || strands > kMaxStrands) {
+			MString msg("strands must be from 1 to ");
+			msg += kMaxStrands;
+			MGlobal::displayError(msg);
+			return MS::kInvalidParameter;
+		}
+	}
+
+	if (argData.isFlagSet(kCombineFlag)) {
+		status = argData.getFlagArgument(kCombineFlag, 0, combine);
+		if (!status) {
+			status.perror("combine flag parsing failed");
+			return status;
+		}
+		if (strands < 2) {
+			MGlobal::displayError("combine needs strands of 2 or more");
+			return MS::kInvalidParameter;
+		}
+	}
+
+	if (strands > 1 && (meshOutput || procedural || cloudName.length() > 0 ||
+		argData.isFlagSet(kPathFlag))) {
+		MGlobal::displayError("strands cannot be combined with mesh, procedural, cloud or path");
+		return MS::kInvalidParameter;
+	}
+
+	// Coils wind around a path curve instead of the Y axis, with
+	// the path's length taking the place of the helix's height.
+	//
+	if (argData.isFlagSet(kPathFlag)) {
+		status = argData.getFlagArgument(kPathFlag, 0, pathName);
+		if (!status) {
+			status.perror("path flag parsing failed");
+			return status;
+		}
+		if (meshOutput || procedural || cloudName.length() > 0) {
+			MGlobal::displayError("path cannot be combined with mesh, procedural or cloud");
+			return MS::kInvalidParameter;
+		}
+
+		MSelectionList list;
+		MDagPath path;
+		if (!list.add(pathName) || !list.getDagPath(0, path) ||
+			!path.extendToShape() || !path.hasFn(MFn::kNurbsCurve)) {
+			MGlobal::displayError(pathName + " is not a NURBS curve");
+			return MS::kInvalidParameter;
+		}
+	}
+
+	// Each helix gets a chain of joints along it, for skinning.
+	//
+	if (argData.isFlagSet(kJointsFlag)) {
+		status = argData.getFlagArgument(kJointsFlag, 0, joints);
+		if (!status || joints < 2) {
+			MGlobal::displayError("joints must be at least 2");
+			return MS::kInvalidParameter;
+		}
+		if (cloudName.length() > 0 || argData.isFlagSet(kPathFlag) ||
+			strands > 1 || tapered || pitchRamp.length() > 0) {
+			MGlobal::displayError("joints cannot be combined with cloud, path, strands, endRadius or pitchRamp");
+			return MS::kInvalidParameter;
+		}
+	}
+
+	// Exporting writes the given curves (or the selection) and
+	// creates nothing.
+	//
+	if (argData.isFlagSet(kExportFileFlag)) {
+		status = argData.getFlagArgument(kExportFileFlag, 0, exportPath);
+		if (!status) {
+			status.perror("exportFile flag parsing failed");
+			return status;
+		}
+		argData.getObjects(exportList);
+		if (exportList.length() == 0)
+			MGlobal::getActiveSelectionList(exportList);
+		return MS::kSuccess;
+	}
+
+	// Importing takes every helix from the file. Files ending in
+	// .csv or .json (or .jsonl) are text, anything else is binary.
+	// Values missing from a text file come from the other flags.
+	//
+	if (argData.isFlagSet(kImportFileFlag)) {
+		status = argData.getFlagArgument(kImportFileFlag, 0, importPath);
+		if (!status) {
+			status.perror("importFile flag parsing failed");
+			return status;
+		}
+
+		MString lower = importPath.toLowerCase();
+		int dot = lower.rindex('.');
+		MString extension = (dot >= 0) ?
+			lower.substring(dot, lower.length() - 1) : MString();
+		importText = (extension == ".csv" || extension == ".json" ||
+			extension == ".jsonl");
+	}
+
+	// The packed form carries every value of every helix, so it
+	// replaces the per-helix flags rather than combining with them.
+	//
+	if (argData.isFlagSet(kPackedFlag)) {
+		MString packed;
+		status = argData.getFlagArgument(kPackedFlag, 0, packed);
+		if (!status) {
+			status.perror("packed flag parsing failed");
+			return status;
+		}
+		status = parsePacked(packed);
+		if (!status)
+			return status;
+		return queued ? MS::kSuccess : checkHelices();
+	}
+
+	unsigned count = 1;
+	const char* flags[] = { kPitchFlag, kRadiusFlag, kNumberCVsFlag, kUpsideDownFlag };
+	for (unsigned f = 0; f < sizeof(flags) / sizeof(flags[0]); f++) {
+		unsigned uses = argData.numberOfFlagUses(flags[f]);
+		if (uses > count)
+			count = uses;
+	}
 
-	if (argData.isFlagSet(kPitchFlag)) {
-		double tmp;
-		status = argData.getFlagArgument(kPitchFlag, 0, tmp);
+	helixDesc defaults;
+	defaults.radius = radius;
+	defaults.pitch = pitch;
+	defaults.numCV = numCV;
+	defaults.upDown = upDown;
+	batch.assign(count, defaults);
+
+	unsigned uses = argData.numberOfFlagUses(kPitchFlag);
+	for (unsigned i = 0; uses > 0 && i < count; i++) {
+		MArgList flagArgs;
+		status = argData.getFlagArgumentList(kPitchFlag, i < uses ? i : uses - 1, flagArgs);
+		if (status)
+			batch[i].pitch = flagArgs.asDouble(0, &status);
 		if (!status) {
 			status.perror("pitch flag parsing failed");
 			return status;
 		}
-		pitch = tmp;
 	}
 
-	if (argData.isFlagSet(kRadiusFlag)) {
-		double tmp;
-		status = argData.getFlagArgument(kRadiusFlag, 0, tmp);
+	uses = argData.numberOfFlagUses(kRadiusFlag);
+	for (unsigned i = 0; uses > 0 && i < count; i++) {
+		MArgList flagArgs;
+		status = argData.getFlagArgumentList(kRadiusFlag, i < uses ? i : uses - 1, flagArgs);
+		if (status)
+			batch[i].radius = flagArgs.asDouble(0, &status);
 		if (!status) {
 			status.perror("radius flag parsing failed");
 			return status;
 		}
-		radius = tmp;
 	}
 
-	if (argData.isFlagSet(kNumberCVsFlag)) {
-		unsigned tmp;
-		status = argData.getFlagArgument(kNumberCVsFlag, 0, tmp);
+	uses = argData.numberOfFlagUses(kNumberCVsFlag);
+	for (unsigned i = 0; uses > 0 && i < count; i++) {
+		MArgList flagArgs;
+		status = argData.getFlagArgumentList(kNumberCVsFlag, i < uses ? i : uses - 1, flagArgs);
+		if (status)
+			batch[i].numCV = flagArgs.asInt(0, &status);
 		if (!status) {
 			status.perror("numCVs flag parsing failed");
 			return status;
 		}
-		numCV = tmp;
 	}
 
-	if (argData.isFlagSet(kUpsideDownFlag)) {
-		bool tmp;
-		status = argData.getFlagArgument(kUpsideDownFlag, 0, tmp);
+	uses = argData.numberOfFlagUses(kUpsideDownFlag);
+	for (unsigned i = 0; uses > 0 && i < count; i++) {
+		MArgList flagArgs;
+		status = argData.getFlagArgumentList(kUpsideDownFlag, i < uses ? i : uses - 1, flagArgs);
+		if (status)
+			batch[i].upDown = flagArgs.asBool(0, &status);
 		if (!status) {
 			status.perror("upside down flag parsing failed");
 			return status;
 		}
-		upDown = tmp;
 	}
 
-	return MS::kSuccess;
+	// A single helix keeps using the plain members, so that the
+	// context's setters and finalize see the parsed values.
+	//
+	if (count == 1) {
+		radius = batch[0].radius;
+		pitch = batch[0].pitch;
+		numCV = batch[0].numCV;
+		upDown = batch[0].upDown;
+		batch.clear();
+	}
+
+	// A populating helixTool leaves checking to nextHelix: its command
+	// checked every helix already, and it stops at a bad one anyway.
+	return queued ? MS::kSuccess : checkHelices();
 }	
 
+MStatus helixTool::parsePacked(const MString& packed)
+	//
+	// Description
+	//     Reads the compact batch form written by journalString: a single
+	//     string of whitespace separated records, each record being
+	//     "radius pitch numCVs upsideDown" with upsideDown as 0 or 1.
+	//
+{
+	batch.clear();
+
+	const char* cursor = packed.asChar();
+	bool truncated = false;
+	for (;;) {
+		while (*cursor == ' ' || *cursor == '\t' || *cursor == '\n')
+			cursor++;
+		if (*cursor == '\0')
+			break;
+
+		helixDesc desc;
+		char* end;
+		truncated = true;
+		desc.radius = strtod(cursor, &end);
+		if (end == cursor) break;
+		cursor = end;
+		desc.pitch = strtod(cursor, &end);
+		if (end == cursor) break;
+		cursor = end;
+		desc.numCV = (unsigned) strtoul(cursor, &end, 10);
+		if (end == cursor) break;
+		cursor = end;
+		desc.upDown = strtol(cursor, &end, 10) != 0;
+		if (end == cursor) break;
+		cursor = end;
+		truncated = false;
+
+		batch.push_back(desc);
+	}
+
+	if (truncated || batch.empty()) {
+		batch.clear();
+		MGlobal::displayError("packed flag expects groups of \"radius pitch numCVs upsideDown\"");
+		return MS::kInvalidParameter;
+	}
+
+	return MS::kSuccess;
+}
+
+MStatus helixTool::parsePitchRamp()
+	//
+	// Description
+	//     Reads the pitch ramp, pairs of position (0 to 1, ascending)
+	//     and pitch scale, and bakes it into pitchTable.
+	//
+{
+	rampPositions.clear();
+	rampValues.clear();
+
+	const char* cursor = pitchRamp.asChar();
+	for (;;) {
+		char* end;
+		double position = strtod(cursor, &end);
+		if (end == cursor)
+			break;
+		cursor = end;
+		double value = strtod(cursor, &end);
+		if (end == cursor || !isFinite(position) || !isFinite(value) ||
+			position < 0.0 || position > 1.0 ||
+			(!rampPositions.empty() && position < rampPositions.back())) {
+			MGlobal::displayError("pitchRamp expects ascending \"position value\" pairs, positions from 0 to 1");
+			return MS::kInvalidParameter;
+		}
+		cursor = end;
+		rampPositions.push_back(position);
+		rampValues.push_back(value);
+	}
+
+	if (rampPositions.empty()) {
+		MGlobal::displayError("pitchRamp is empty");
+		return MS::kInvalidParameter;
+	}
+
+	pitchTable.resize(kPitchTableSize);
+	helixBakePitchTable(&rampPositions[0], &rampValues[0],
+		(unsigned) rampPositions.size(), &pitchTable[0]);
+	return MS::kSuccess;
+}
+
+MString helixTool::packedString() const
+	//
+	// Description
+	//     Packs every helix of the command into the string read back
+	//     by parsePacked.
+	//
+{
+	unsigned count = helixCount();
+	std::string packed;
+	packed.reserve(count * 48);
+
+	char record[96];
+	for (unsigned h = 0; h < count; h++) {
+		helixDesc desc = helixAt(h);
+		sprintf(record, "%s%.17g %.17g %u %d", h ? " " : "",
+			desc.radius, desc.pitch, desc.numCV, desc.upDown ? 1 : 0);
+		packed += record;
+	}
+
+	return MString(packed.c_str());
+}
+
+static MString melQuoted(const MString& value)
+{
+	std::string quoted("\"");
+	for (const char* c = value.asChar(); *c; c++) {
+		if (*c == '"' || *c == '\\')
+			quoted += '\\';
+		quoted += *c;
+	}
+	quoted += '"';
+	return MString(quoted.c_str());
+}
+
+MString helixTool::journalString() const
+	//
+	// Description
+	//     The command as a batch is journaled: the flags that apply to
+	//     every helix, then the helices themselves packed into one
+	//     string, so that the journal grows by a few bytes per helix
+	//     rather than by four flags.
+	//
+{
+	MString command("helixToolCmd");
+	char value[64];
+
+	if (meshOutput) {
+		sprintf(value, " %s true %s %.17g %s %u %s %u", kMeshFlag,
+			kTubeRadiusFlag, tubeRadius, kTubeSidesFlag, tubeSides,
+			kTubeSegmentsFlag, tubeSegments);
+		command += value;
+	}
+	if (procedural) {
+		command += " " kProceduralFlag " true";
+	}
+	if (incremental) {
+		command += " " kIncrementalFlag " true";
+	}
+	if (cloudName.length() > 0) {
+		command += " " kCloudFlag " ";
+		command += melQuoted(cloudName);
+	}
+	if (pathName.length() > 0) {
+		command += " " kPathFlag " ";
+		command += melQuoted(pathName);
+	}
+	if (tapered) {
+		sprintf(value, " %s %.17g", kEndRadiusFlag, endRadius);
+		command += value;
+	}
+	if (pitchRamp.length() > 0) {
+		command += " " kPitchRampFlag " ";
+		command += melQuoted(pitchRamp);
+	}
+	if (strands > 1) {
+		sprintf(value, " %s %u %s %s", kStrandsFlag, strands,
+			kCombineFlag, combine ? "true" : "false");
+		command += value;
+	}
+	if (joints > 0) {
+		sprintf(value, " %s %u", kJointsFlag, joints);
+		command += value;
+	}
+
+	command += " " kPackedFlag " ";
+	command += melQuoted(packedString());
+	return command;
+}
+
+unsigned helixTool::helixCount() const
+{
+	return batch.empty() ? 1 : (unsigned) batch.size();
+}
+
+helixDesc helixTool::helixAt(unsigned index) const
+{
+	if (!batch.empty())
+		return batch[index];
+
+	helixDesc desc;
+	desc.radius = radius;
+	desc.pitch = pitch;
+	desc.numCV = numCV;
+	desc.upDown = upDown;
+	return desc;
+}
+
+static bool validHelix(const helixDesc& desc, MString& reason)
+	//
+	// Description
+	//     The rules every helix must meet, whatever it was read from.
+	//
+{
+	if (!isFinite(desc.radius) || desc.radius <= 0.0) {
+		reason = "radius must be greater than 0";
+		return false;
+	}
+	if (!isFinite(desc.pitch)) {
+		reason = "pitch must be finite";
+		return false;
+	}
+	if (desc.numCV < 4) {
+		reason = "numCVs must be at least 4";
+		return false;
+	}
+	if (desc.hasMatrix) {
+		for (unsigned i = 0; i < 4; i++) {
+			for (unsigned j = 0; j < 4; j++) {
+				if (!isFinite(desc.matrix[i][j])) {
+					reason = "matrix values must be finite";
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+MStatus helixTool::beginHelices()
+	//
+	// Description
+	//     Starts a pass over the helices of the command. Files are
+	//     mapped here and unmapped by endHelices, so nothing is held
+	//     open, or copied, between passes.
+	//
+{
+	cursor = 0;
+
+	if (importPath.length() == 0)
+		return MS::kSuccess;
+
+	if (importText)
+		return textFile.open(importPath);
+	return binaryFile.open(importPath);
+}
+
+MStatus helixTool::nextHelix(helixDesc& desc, bool& done)
+	//
+	// Description
+	//     Reads the next helix of the pass and checks it with
+	//     validHelix. done is set once every helix has been read.
+	//
+{
+	MStatus stat;
+	MString where;
+	done = false;
+
+	if (importPath.length() == 0) {
+		if (cursor >= helixCount()) {
+			done = true;
+			return stat;
+		}
+		desc = helixAt((unsigned) cursor);
+		where = "helix ";
+		where += (unsigned) cursor;
+	}
+	else if (!importText) {
+		if (cursor >= binaryFile.count()) {
+			done = true;
+			return stat;
+		}
+		helixFileRecord record;
+		binaryFile.read(cursor, record);
+		desc.radius = record.radius;
+		desc.pitch = record.pitch;
+		desc.numCV = record.numCV;
+		desc.upDown = record.upsideDown;
+		desc.hasMatrix = true;
+		desc.matrix = MMatrix(record.matrix);
+
+		// Records past 2^32 need all 64 bits of the index.
+		char index[32];
+		sprintf(index, "%llu", (unsigned long long) cursor);
+		where = importPath + ": record " + index;
+	}
+	else {
+		helixTextRecord record;
+		stat = textFile.next(record, done);
+		if (!stat || done)
+			return stat;
+
+		desc.radius = (record.present & helixTextRecord::kRadius) ? record.radius : radius;
+		desc.pitch = (record.present & helixTextRecord::kPitch) ? record.pitch : pitch;
+		desc.numCV = (record.present & helixTextRecord::kNumCVs) ? record.numCV : numCV;
+		desc.upDown = (record.present & helixTextRecord::kUpsideDown) ? record.upsideDown : upDown;
+
+		const unsigned translate = helixTextRecord::kTranslateX |
+			helixTextRecord::kTranslateY | helixTextRecord::kTranslateZ;
+		desc.hasMatrix = (record.present & translate) != 0;
+		desc.matrix = MMatrix::identity;
+		if (record.present & helixTextRecord::kTranslateX) desc.matrix[3][0] = record.translate[0];
+		if (record.present & helixTextRecord::kTranslateY) desc.matrix[3][1] = record.translate[1];
+		if (record.present & helixTextRecord::kTranslateZ) desc.matrix[3][2] = record.translate[2];
+
+		where = importPath + ":";
+		where += record.line;
+	}
+
+	cursor++;
+
+	// A negative pitch builds the helix downwards, as upsideDown
+	// does, so it is stored that way and later code sees pitch >= 0.
+	//
+	if (desc.pitch < 0.0) {
+		desc.pitch = -desc.pitch;
+		desc.upDown = !desc.upDown;
+	}
+
+	MString reason;
+	if (!validHelix(desc, reason)) {
+		stat = MS::kInvalidParameter;
+		stat.perror(where + ": " + reason);
+	}
+	return stat;
+}
+
+void helixTool::endHelices()
+{
+	binaryFile.close();
+	textFile.close();
+}
+
+MStatus helixTool::checkHelices()
+	//
+	// Description
+	//     Validates every helix of the command before anything is
+	//     created. For imports this is a streaming pass over the file,
+	//     which costs far less than building the curves. A file that
+	//     holds no helices is an error too.
+	//
+{
+	MStatus stat = beginHelices();
+	if (!stat)
+		return stat;
+
+	helixDesc desc;
+	bool done = false;
+	MUint64 count = 0;
+	for (;;) {
+		stat = nextHelix(desc, done);
+		if (!stat || done)
+			break;
+		count++;
+	}
+
+	endHelices();
+
+	if (stat && count == 0) {
+		stat = MS::kInvalidParameter;
+		stat.perror(importPath + ": no helices in file");
+	}
+	return stat;
+}
+
+
+MStatus helixTool::redoIt()
+	//
+	// Description
+	//     This method creates the helix curves from the
+	//     pitch and radius values
+	//
+{
+	MStatus stat;
+
+	if (arenaStats) {
+		// Buffers handed out, how many of those reallocated, and
+		// the bytes the arena holds, as doubles so that sizes over
+		// 2GB come through.
+		const helixArena& arena = helixGetArena();
+		MDoubleArray result;
+		result.append((double) arena.requests());
+		result.append((double) arena.reallocations());
+		result.append((double) arena.reservedBytes());
+		setResult(result);
+		return MS::kSuccess;
+	}
+	if (exportPath.length() > 0)
+		return exportHelices();
+	if (cloudName.length() > 0)
+		return addToCloud();
+
+	created->transforms.clear();
+	helicesCreated = 0;
+	created->historyNodes.clear();
+	created->jointRoots.clear();
+	if (incremental)
+		return queuePopulation();
+	helixGetArena().beginBatch();
+
+	// Helices are read one at a time as they are built, straight
+	// from the mapping when importing.
+	//
+	stat = beginHelices();
+	if (!stat)
+		return stat;
+
+	beginProgress();
+
+	helixDesc desc;
+	bool done = false;
+	while (helicesCreated < createLimit) {
+		if (helicesCreated % kProgressChunk == 0 &&
+			progressInterrupted(helicesCreated))
+			break;
+
+		stat = nextHelix(desc, done);
+		if (stat && done)
+			break;
+
+		MObject transform;
+		if (stat)
+			stat = createHelix(desc, transform);
+		if (!stat && interrupted)
+			break;
+		if (!stat) {
+			// Leave the scene as it was before the command.
+			endProgress();
+			endHelices();
+			springShapes.clear();
+			jointParents.clear();
+			jointHelices.clear();
+			deleteHelices();
+			return stat;
+		}
+		created->transforms.append(transform);
+		helicesCreated++;
+		if (joints > 0) {
+			jointParents.append(transform);
+			jointHelices.push_back(desc);
+		}
+	}
+
+	endProgress();
+	endHelices();
+
+	if (interrupted) {
+		// Keep what was built, as the whole of the command, so that
+		// undo removes it in one step and redo builds the same again.
+		//
+		if (helicesCreated == 0) {
+			displayWarning("helixToolCmd: interrupted, no helices created");
+			return MS::kFailure;
+		}
+
+		MString msg("helixToolCmd: interrupted after ");
+		msg += helicesCreated;
+		msg += " helices";
+		displayWarning(msg);
+
+		createLimit = helicesCreated;
+		if (!batch.empty())
+			batch.resize(createLimit);
+		interrupted = false;
+	}
+
+	stat = createJoints();
+	if (!stat) {
+		springShapes.clear();
+		deleteHelices();
+		return stat;
+	}
+	return shadeSprings();
+}
+
+MStatus helixTool::queuePopulation()
+	//
+	// Description
+	//     Queues a new helixTool, parsed from this command's arguments,
+	//     to create the helices on idle into this command's created
+	//     nodes. The queue outlives the command, so the helices keep
+	//     coming if the command is flushed from the undo queue first.
+	//
+{
+	helixTool* worker = new helixTool;
+	worker->queued = true;
+	MStatus stat = worker->parseArgs(commandArgs);
+	if (stat)
+		stat = worker->beginHelices();
+	if (stat && populateQueue.empty()) {
+		populateCallback = MEventMessage::addEventCallback("idle",
+			populateIdle, NULL, &stat);
+		if (!stat)
+			stat.perror("Could not add idle callback");
+	}
+	if (!stat) {
+		delete worker;
+		return stat;
+	}
+
+	delete worker->created;
+	worker->created = created;
+	created->refs++;
+	helixGetArena().beginBatch();
+	populateQueue.push_back(worker);
+	return MS::kSuccess;
+}
+
+void helixTool::cancelPopulation()
+	//
+	// Description
+	//     Drops the helixTool still creating this command's helices,
+	//     if there is one.
+	//
+{
+	for (size_t i = 0; i < populateQueue.size(); i++) {
+		if (populateQueue[i]->created == created) {
+			delete populateQueue[i];
+			populateQueue.erase(populateQueue.begin() + i);
+			break;
+		}
+	}
+	if (populateQueue.empty() && populateCallback != 0) {
+		MMessage::removeCallback(populateCallback);
+		populateCallback = 0;
+	}
+}
+
+void helixTool::clearPopulateQueue()
+	//
+	// Description
+	//     Stops every incremental command where it is, as the plug-in
+	//     is unloaded. The helices made so far stay.
+	//
+{
+	for (size_t i = 0; i < populateQueue.size(); i++)
+		delete populateQueue[i];
+	populateQueue.clear();
+	if (populateCallback != 0) {
+		MMessage::removeCallback(populateCallback);
+		populateCallback = 0;
+	}
+}
+
+void helixTool::populateIdle(void*)
+	//
+	// Description
+	//     Gives the helixTool at the front of the queue one slice, and
+	//     frees it once it is done.
+	//
+{
+	if (populateQueue.empty())
+		return;
+
+	helixTool* worker = populateQueue.front();
+	if (!worker->populateSlice())
+		return;
+
+	populateQueue.erase(populateQueue.begin());
+	delete worker;
+	if (populateQueue.empty()) {
+		MMessage::removeCallback(populateCallback);
+		populateCallback = 0;
+	}
+}
+
+bool helixTool::populateSlice()
+	//
+	// Description
+	//     Creates helices for one idle event, until kIncrementalSlice
+	//     has passed. The pass started by queuePopulation stays open
+	//     between slices, so each one carries on from the last helix
+	//     created. Returns true once there is nothing more to create.
+	//
+{
+	MStatus stat;
+	MTimer timer;
+	timer.beginTimer();
+
+	helixDesc desc;
+	bool done = false;
+	bool finished = false;
+	do {
+		if (helicesCreated >= createLimit)
+			done = true;
+		else
+			stat = nextHelix(desc, done);
+
+		if (stat && done) {
+			finished = true;
+			break;
+		}
+
+		MObject transform;
+		if (stat)
+			stat = createHelix(desc, transform);
+		if (!stat) {
+			// The helices made so far stay, and undo removes them.
+			MString msg("helixToolCmd: stopped after ");
+			msg += helicesCreated;
+			msg += " helices";
+			MGlobal::displayError(msg);
+			createLimit = helicesCreated;
+			finished = true;
+			break;
+		}
+		created->transforms.append(transform);
+		helicesCreated++;
+		if (joints > 0) {
+			jointParents.append(transform);
+			jointHelices.push_back(desc);
+		}
+
+		timer.endTimer();
+	} while (timer.elapsedTime() < kIncrementalSlice);
+
+	stat = createJoints();
+	if (stat)
+		stat = shadeSprings();
+	if (!stat) {
+		// As above, the helices made so far stay for undo to remove.
+		MString msg("helixToolCmd: stopped after ");
+		msg += helicesCreated;
+		msg += " helices";
+		MGlobal::displayError(msg);
+		springShapes.clear();
+		createLimit = helicesCreated;
+		finished = true;
+	}
+
+	if (finished)
+		endHelices();
+	return finished;
+}
+
+void helixTool::beginProgress()
+	//
+	// Description
+	//     Shows Maya's progress bar for imports and large batches.
+	//     Short commands go without, as the bar costs more than they
+	//     do.
+	//
+{
+	interrupted = false;
+	showProgress = importPath.length() > 0 ||
+		helixCount() >= kProgressChunk;
+	if (!showProgress)
+		return;
+
+	computation.beginComputation(true, true, true);
+	computation.setProgressRange(0, 100);
+	computation.setProgressStatus("Creating helices");
+}
+
+bool helixTool::progressInterrupted(unsigned created)
+	//
+	// Description
+	//     Updates the progress bar and returns true, once, when the
+	//     user has asked to interrupt. Called between helices, with
+	//     the number created so far.
+	//
+{
+	if (!showProgress)
+		return false;
+
+	double fraction;
+	if (importPath.length() == 0)
+		fraction = (double) created / (double) helixCount();
+	else if (importText)
+		fraction = textFile.progress();
+	else
+		fraction = binaryFile.count() ?
+			(double) created / (double) binaryFile.count() : 1.0;
+	computation.setProgress((int) (100.0 * fraction));
+
+	if (!interrupted && computation.isInterruptRequested())
+		interrupted = true;
+	return interrupted;
+}
+
+void helixTool::endProgress()
+{
+	if (showProgress)
+		computation.endComputation();
+	showProgress = false;
+}
+
+MStatus helixTool::createHelix(const helixDesc& desc, MObject& transform)
+	//
+	// Description
+	//     Creates one helix curve and returns the transform above it.
+	//
+	//     Unlike deletion, creation is not queued on an MDagModifier:
+	//     the modifier can only create empty nodes, so each curve would
+	//     still need its geometry built as curve data and set on the
+	//     shape's plug, costing as much as MFnNurbsCurve::create doing
+	//     all three in one call. It would also leave the transforms
+	//     unusable as parents until the modifier's doIt.
+	//
+{
+	MStatus stat;
+
+	if (meshOutput)
+		return createSpring(desc, transform);
+	if (procedural)
+		return createProceduralHelix(desc, transform);
+	if (pathName.length() > 0)
+		return createCoil(desc, transform);
+	if (strands > 1)
+		return createStrands(desc, transform);
+
+	const unsigned  deg     = 3;            // Curve Degree
+	const unsigned  ncvs    = desc.numCV;	// Number of CVs
+	const unsigned  nknots  = helixCurveKnotCount(ncvs);
+	unsigned	    i;
+
+	int upFactor;
+	if (desc.upDown) upFactor = -1;
+	else upFactor = 1;
+
+	// Set up cvs and knots for the helix with helixCurve(), as
+	// helixNode does, in the arena's buffers, unless the tool context
+	// built the CVs in the background already. The arena's knots are
+	// helixCurve's.
+	//
+	helixArena& arena = helixGetArena();
+	const double (*profile)[4] = profileCVs;
+	if (profile == NULL) {
+		double (*cvs)[4] = (double (*)[4]) arena.doubles(4 * (size_t) ncvs);
+		helixCurve(desc.radius, tapered ? endRadius : desc.radius,
+			upFactor * desc.pitch, pitchTable.empty() ? NULL : &pitchTable[0],
+			ncvs, cvs, NULL);
+		profile = cvs;
+	}
+
+	MPointArray& controlVertices = arena.points(ncvs);
+	for (i = 0; i < ncvs; i++)
+		controlVertices[i] = MPoint(profile[i][0], profile[i][1], profile[i][2]);
+	const MDoubleArray& knotSequences = arena.knots(nknots);
+
+	// Now create the curve
+	//
+	MFnNurbsCurve curveFn;
+
+	MObject curve = curveFn.create(controlVertices, knotSequences, deg, 
+		MFnNurbsCurve::kOpen, false, false, 
+		MObject::kNullObj, &stat);
+
+	if (!stat) {
+		stat.perror("Error creating curve");
+		return stat;
+	}
+
+	// With no parent given, create() returns the new transform.
+	transform = curve;
+
+	if (desc.hasMatrix) {
+		MFnTransform transformFn(transform);
+		stat = transformFn.set(MTransformationMatrix(desc.matrix));
+	}
+
+	return stat;
+}
+
+MStatus helixTool::createStrands(const helixDesc& desc, MObject& transform)
+	//
+	// Description
+	//     Creates the strands of one helix from a single pass of
+	//     helixStrandCVs. Combined strands are curve shapes under
+	//     the first strand's transform; otherwise every strand after
+	//     the first gets a transform of its own, which goes straight
+	//     into transforms so that undo deletes it.
+	//
+{
+	MStatus stat;
+	const unsigned deg = 3;
+	const unsigned ncvs = desc.numCV;
+	const unsigned nknots = ncvs - deg + 2 * deg - 1;
+
+	helixArena& arena = helixGetArena();
+	double (*cvs)[4] = (double (*)[4]) arena.doubles(4 * (size_t) ncvs * strands);
+	helixStrandCVs(desc.radius, tapered ? endRadius : desc.radius,
+		desc.upDown ? -desc.pitch : desc.pitch,
+		pitchTable.empty() ? NULL : &pitchTable[0], ncvs, strands, cvs);
+
+	const MDoubleArray& knotSequences = arena.knots(nknots);
+	MPointArray& controlVertices = arena.points(ncvs);
+
+	for (unsigned k = 0; k < strands; k++) {
+		const double (*strand)[4] = cvs + (size_t) k * ncvs;
+		for (unsigned i = 0; i < ncvs; i++)
+			controlVertices[i] = MPoint(strand[i][0], strand[i][1], strand[i][2]);
+
+		MObject parent = (combine && k > 0) ? transform : MObject::kNullObj;
+		MFnNurbsCurve curveFn;
+		MObject curve = curveFn.create(controlVertices, knotSequences, deg,
+			MFnNurbsCurve::kOpen, false, false, parent, &stat);
+		if (!stat) {
+			stat.perror("Error creating strand");
+			if (k > 0)
+				created->transforms.append(transform);	// Deleted with the rest
+			return stat;
+		}
+
+		if (parent.isNull() && desc.hasMatrix) {
+			MFnTransform transformFn(curve);
+			stat = transformFn.set(MTransformationMatrix(desc.matrix));
+			if (!stat) {
+				stat.perror("Error placing strand");
+				if (k > 0)
+					created->transforms.append(transform);
+				created->transforms.append(curve);	// Deleted with the rest
+				return stat;
+			}
+		}
+
+		if (k == 0)
+			transform = curve;
+		else if (parent.isNull())
+			created->transforms.append(curve);
+	}
+
+	return stat;
+}
+
+MStatus helixTool::createProceduralHelix(const helixDesc& desc, MObject& transform)
+	//
+	// Description
+	//     Creates a nurbsCurve whose create attribute is driven by a
+	//     new helixNode holding the helix parameters.
+	//
+{
+	MStatus stat;
+	MDagModifier dagMod;
+
+	transform = dagMod.createNode("transform", MObject::kNullObj, &stat);
+	if (!stat)
+		return stat;
+	MObject shape = dagMod.createNode("nurbsCurve", transform, &stat);
+	if (!stat)
+		return stat;
+	MObject node = dagMod.MDGModifier::createNode(helixNode::id, &stat);
+	if (!stat)
+		return stat;
+
+	MFnDependencyNode shapeFn(shape);
+	stat = dagMod.connect(node, helixNode::outputCurve,
+		shape, shapeFn.attribute("create"));
+	if (!stat)
+		return stat;
+
+	stat = dagMod.doIt();
+	if (!stat) {
+		stat.perror("Error creating procedural helix");
+		return stat;
+	}
+	created->historyNodes.append(node);
+
+	MPlug(node, helixNode::radius).setValue(desc.radius);
+	MPlug(node, helixNode::pitch).setValue(desc.pitch);
+	MPlug(node, helixNode::numCVs).setValue((int) desc.numCV);
+	MPlug(node, helixNode::upsideDown).setValue(desc.upDown);
+	if (tapered) {
+		MPlug(node, helixNode::tapered).setValue(true);
+		MPlug(node, helixNode::endRadius).setValue(endRadius);
+	}
+	if (!rampPositions.empty()) {
+		MFloatArray positions, values;
+		MIntArray interps;
+		for (unsigned i = 0; i < rampPositions.size(); i++) {
+			positions.append((float) rampPositions[i]);
+			values.append((float) rampValues[i]);
+			interps.append(MRampAttribute::kLinear);
+		}
+		MRampAttribute ramp(node, helixNode::pitchRamp, &stat);
+		if (stat)
+			ramp.addEntries(positions, values, interps, &stat);
+		if (!stat)
+			return stat;
+	}
+
+	if (desc.hasMatrix) {
+		MFnTransform transformFn(transform);
+		stat = transformFn.set(MTransformationMatrix(desc.matrix));
+	}
+
+	return stat;
+}
+
+// Frames of a path curve, kept while the curve is unchanged.
+//
+struct helixPathCacheEntry
+{
+	MString			name;			// Full DAG path of the curve shape
+	unsigned		signature;		// Hash of its world space CVs
+	helixPathFrames	frames;
+};
+
+static std::vector<helixPathCacheEntry*> pathCache;
+
+static void clearPathCache()
+{
+	for (unsigned i = 0; i < pathCache.size(); i++)
+		delete pathCache[i];
+	pathCache.clear();
+}
+
+static unsigned curveSignature(const MFnNurbsCurve& curveFn)
+	//
+	// Description
+	//     FNV-1a over the world space CVs, the knots and the curve's
+	//     degree and form, which is all that the frames depend on.
+	//     Reading them costs far less than sampling the curve again.
+	//
+{
+	MPointArray cvs;
+	curveFn.getCVs(cvs, MSpace::kWorld);
+	MDoubleArray knots;
+	curveFn.getKnots(knots);
+
+	unsigned hash = 2166136261u;
+	unsigned header[2] = { (unsigned) curveFn.degree(), (unsigned) curveFn.form() };
+	const unsigned char* bytes = (const unsigned char*) header;
+	for (unsigned b = 0; b < sizeof(header); b++)
+		hash = (hash ^ bytes[b]) * 16777619u;
+
+	for (unsigned i = 0; i < cvs.length(); i++) {
+		double xyz[3] = { cvs[i].x, cvs[i].y, cvs[i].z };
+		bytes = (const unsigned char*) xyz;
+		for (unsigned b = 0; b < sizeof(xyz); b++)
+			hash = (hash ^ bytes[b]) * 16777619u;
+	}
+	for (unsigned i = 0; i < knots.length(); i++) {
+		const double knot = knots[i];
+		bytes = (const unsigned char*) &knot;
+		for (unsigned b = 0; b < sizeof(knot); b++)
+			hash = (hash ^ bytes[b]) * 16777619u;
+	}
+	return hash;
+}
+
+static MStatus getPathFrames(const MString& name, const helixPathFrames*& frames)
+	//
+	// Description
+	//     Returns the frames of the named curve, sampling it only if
+	//     it is new or has changed since its frames were built. Each
+	//     span is sampled evenly in parameter with world space points
+	//     and tangents, and arc length measured along the samples.
+	//
+{
+	MStatus stat;
+	MSelectionList list;
+	MDagPath path;
+	if (!list.add(name) || !list.getDagPath(0, path) || !path.extendToShape() ||
+		!path.hasFn(MFn::kNurbsCurve)) {
+		MGlobal::displayError(name + " is not a NURBS curve");
+		return MS::kInvalidParameter;
+	}
+
+	MFnNurbsCurve curveFn(path, &stat);
+	if (!stat)
+		return stat;
+
+	const MString key = path.fullPathName();
+	const unsigned signature = curveSignature(curveFn);
+
+	for (unsigned i = 0; i < pathCache.size(); i++) {
+		if (pathCache[i]->name == key) {
+			if (pathCache[i]->signature == signature) {
+				frames = &pathCache[i]->frames;
+				return MS::kSuccess;
+			}
+			delete pathCache[i];
+			pathCache.erase(pathCache.begin() + i);
+			break;
+		}
+	}
+
+	double start, end;
+	stat = curveFn.getKnotDomain(start, end);
+	if (!stat)
+		return stat;
+
+	unsigned count = (unsigned) curveFn.numSpans() * kPathSamplesPerSpan + 1;
+	if (count < kMinPathSamples)
+		count = kMinPathSamples;
+
+	std::vector<double> points(3 * (size_t) count);
+	std::vector<double> tangents(3 * (size_t) count);
+	for (unsigned i = 0; i < count; i++) {
+		double param = start + (end - start) * (double) i / (double) (count - 1);
+		MPoint point;
+		curveFn.getPointAtParam(param, point, MSpace::kWorld);
+		MVector tangent = curveFn.tangent(param, MSpace::kWorld);
+		points[3 * i] = point.x;
+		points[3 * i + 1] = point.y;
+		points[3 * i + 2] = point.z;
+		tangents[3 * i] = tangent.x;
+		tangents[3 * i + 1] = tangent.y;
+		tangents[3 * i + 2] = tangent.z;
+	}
+
+	if (pathCache.size() >= kMaxCachedPaths)
+		clearPathCache();
+
+	helixPathCacheEntry* entry = new helixPathCacheEntry;
+	entry->name = key;
+	entry->signature = signature;
+	helixBuildPathFrames((const double (*)[3]) &points[0],
+		(const double (*)[3]) &tangents[0], count, entry->frames);
+	pathCache.push_back(entry);
+
+	frames = &entry->frames;
+	return MS::kSuccess;
+}
+
+MStatus helixTool::createCoil(const helixDesc& desc, MObject& transform)
+	//
+	// Description
+	//     Creates a helix curve coiled around the path curve, with
+	//     CVs placed in the path's rotation minimizing frames. The
+	//     frames are cached per path, so coiling the same path again
+	//     with another radius or pitch is a single pass over its CVs.
+	//     The curve stops at the end of the path. The CVs are in world
+	//     space already, so a placement the helix carries, as from an
+	//     imported file, is not applied.
+	//
+{
+	MStatus stat;
+	const helixPathFrames* frames = NULL;
+
+	stat = getPathFrames(pathName, frames);
+	if (!stat)
+		return stat;
+
+	helixArena& arena = helixGetArena();
+	double (*cvs)[4] = (double (*)[4]) arena.doubles(4 * (size_t) desc.numCV);
+	const unsigned ncvs = helixCoilCVs(*frames, desc.radius, desc.pitch,
+		desc.upDown, desc.numCV, cvs);
+	if (ncvs < 4) {
+		MGlobal::displayError(pathName + " is too short to coil around at this pitch");
+		return MS::kInvalidParameter;
+	}
+
+	MPointArray& controlVertices = arena.points(ncvs);
+	for (unsigned i = 0; i < ncvs; i++)
+		controlVertices[i] = MPoint(cvs[i][0], cvs[i][1], cvs[i][2]);
+
+	const unsigned deg = 3;
+	MFnNurbsCurve curveFn;
+	transform = curveFn.create(controlVertices, arena.knots(ncvs - deg + 2 * deg - 1),
+		deg, MFnNurbsCurve::kOpen, false, false, MObject::kNullObj, &stat);
+	if (!stat) {
+		stat.perror("Error creating coil");
+		return stat;
+	}
+
+	return stat;
+}
+
+MStatus helixTool::createSpring(const helixDesc& desc, MObject& transform)
+	//
+	// Description
+	//     Creates a polygon spring around the helix curve directly,
+	//     in place of extruding a profile along it. Vertices, normals
+	//     and UVs are analytic; the face and UV lists are shared by
+	//     all springs with the same number of rings and sides.
+	//
+{
+	MStatus stat;
+
+	helixSpringDesc spring;
+	spring.radius = helixCurveRadius(desc.radius);
+	spring.rise = desc.upDown ? -desc.pitch : desc.pitch;
+	spring.tubeRadius = tubeRadius;
+	spring.startAngle = 1.0;
+	spring.endAngle = (double) (desc.numCV - 2);
+	spring.segments = (desc.numCV - 3) * tubeSegments;
+	spring.sides = tubeSides;
+
+	const helixSpringTopology& topo =
+		helixGetSpringTopology(spring.segments, spring.sides);
+
+	helixArena& arena = helixGetArena();
+	float* points = arena.floats(4 * (size_t) topo.numVertices);
+	double* normals = arena.doubles(3 * (size_t) topo.numVertices);
+	helixSpringRingsParallel(spring,
+		(float (*)[4]) points, (double (*)[3]) normals);
+
+	MFloatPointArray vertexArray((const float (*)[4]) points, topo.numVertices);
+
+	MFnMesh meshFn;
+	transform = meshFn.create(topo.numVertices, topo.numPolygons, vertexArray,
+		topo.polygonCounts, topo.polygonConnects, topo.uArray, topo.vArray,
+		MObject::kNullObj, &stat);
+	if (!stat) {
+		stat.perror("Error creating spring mesh");
+		return stat;
+	}
+
+	stat = meshFn.assignUVs(topo.uvCounts, topo.uvIds);
+	if (!stat) {
+		stat.perror("Error assigning spring UVs");
+		return stat;
+	}
+
+	MVectorArray normalArray((const double (*)[3]) normals, topo.numVertices);
+	stat = meshFn.setVertexNormals(normalArray, topo.vertexList, MSpace::kObject);
+	if (!stat) {
+		stat.perror("Error setting spring normals");
+		return stat;
+	}
+
+	if (desc.hasMatrix) {
+		MFnTransform transformFn(transform);
+		stat = transformFn.set(MTransformationMatrix(desc.matrix));
+	}
+
+	springShapes.add(meshFn.object());
+	return stat;
+}
+
+MStatus helixTool::shadeSprings()
+	//
+	// Description
+	//     Puts the spring meshes made by redoIt in the initial shading
+	//     group, all in one call.
+	//
+{
+	if (springShapes.length() == 0)
+		return MS::kSuccess;
+
+	MSelectionList groupList;
+	MObject shadingGroup;
+	MStatus stat = groupList.add("initialShadingGroup");
+	if (stat)
+		stat = groupList.getDependNode(0, shadingGroup);
+	if (stat) {
+		MFnSet setFn(shadingGroup);
+		stat = setFn.addMembers(springShapes);
+	}
+
+	springShapes.clear();
+	return stat;
+}
+
+MStatus helixTool::createJoints()
+	//
+	// Description
+	//     Builds a chain of joints for each transform made by redoIt.
+	//     helixJointFrames() gives every joint's translation and
+	//     orientation in its parent's space straight from the helix,
+	//     and all the chains are created and set by one MDagModifier,
+	//     so the DAG is changed once however many springs there are.
+	//
+	//     A chain is not put under its helix's transform, which would
+	//     move a shape skinned to it twice. Its root is a sibling of
+	//     the transform instead, with the transform's matrix baked
+	//     into it, and deleteHelices removes it on undo.
+	//
+{
+	const unsigned helices = jointParents.length();
+	if (helices == 0)
+		return MS::kSuccess;
+
+	MStatus stat;
+	MDagModifier dagMod;
+	MObjectArray roots;
+	std::vector<double> translates(3 * (size_t) joints);
+	std::vector<double> orients(3 * (size_t) joints);
+	const char* translateNames[] = { "translateX", "translateY", "translateZ" };
+	const char* orientNames[] = { "jointOrientX", "jointOrientY", "jointOrientZ" };
+	const char* scaleNames[] = { "scaleX", "scaleY", "scaleZ" };
+
+	for (unsigned h = 0; h < helices && stat; h++) {
+		const helixDesc& desc = jointHelices[h];
+		const double rise = desc.upDown ? -desc.pitch : desc.pitch;
+		helixJointFrames(desc.radius, rise, desc.numCV, joints,
+			(double (*)[3]) &translates[0], (double (*)[3]) &orients[0]);
+
+		// The first joint's frame is in the helix's space; take it on
+		// into the space of the transform's parent.
+		MFnDagNode transformFn(jointParents[h]);
+		MMatrix rootMatrix = MEulerRotation(orients[0], orients[1], orients[2]).asMatrix();
+		for (unsigned k = 0; k < 3; k++)
+			rootMatrix[3][k] = translates[k];
+		MTransformationMatrix rootXform(rootMatrix * transformFn.transformationMatrix());
+		const MVector rootTranslate = rootXform.getTranslation(MSpace::kTransform);
+		const MEulerRotation rootOrient =
+			rootXform.eulerRotation().reorder(MEulerRotation::kXYZ);
+		double rootScale[3];
+		rootXform.getScale(rootScale, MSpace::kTransform);
+		translates[0] = rootTranslate.x;
+		translates[1] = rootTranslate.y;
+		translates[2] = rootTranslate.z;
+		orients[0] = rootOrient.x;
+		orients[1] = rootOrient.y;
+		orients[2] = rootOrient.z;
+
+		MObject parent = MObject::kNullObj;
+		if (transformFn.parentCount() > 0) {
+			MObject above = transformFn.parent(0);
+			if (!above.hasFn(MFn::kWorld))
+				parent = above;
+		}
+
+		for (unsigned j = 0; j < joints; j++) {
+			MObject joint = dagMod.createNode("joint", parent, &stat);
+			if (!stat) {
+				stat.perror("helixToolCmd: creating joint");
+				break;
+			}
+			MFnDependencyNode jointFn(joint);
+			for (unsigned k = 0; k < 3; k++) {
+				dagMod.newPlugValueDouble(jointFn.findPlug(translateNames[k]),
+					translates[3 * j + k]);
+				dagMod.newPlugValueDouble(jointFn.findPlug(orientNames[k]),
+					orients[3 * j + k]);
+				if (j == 0)
+					dagMod.newPlugValueDouble(jointFn.findPlug(scaleNames[k]),
+						rootScale[k]);
+			}
+			if (j == 0)
+				roots.append(joint);
+			parent = joint;
+		}
+	}
+
+	jointParents.clear();
+	jointHelices.clear();
+	if (!stat)
+		return stat;
+
+	stat = dagMod.doIt();
+	if (!stat) {
+		stat.perror("helixToolCmd: building joint chains");
+		return stat;
+	}
+	for (unsigned i = 0; i < roots.length(); i++)
+		created->jointRoots.append(roots[i]);
+	return stat;
+}
+
+static bool recoverHelix(const MFnNurbsCurve& curveFn, helixDesc& desc)
+	//
+	// Description
+	//     Recovers the parameters of a curve built by createHelix from
+	//     its object space CVs. Returns false for any other curve.
+	//
+{
+	MPointArray cvs;
+	if (curveFn.degree() != 3 || !curveFn.getCVs(cvs, MSpace::kObject) ||
+		cvs.length() < 4)
+		return false;
+
+	double radius = sqrt(cvs[0].x * cvs[0].x + cvs[0].z * cvs[0].z);
+	double step = cvs[1].y - cvs[0].y;
+	double tolerance = 1.0e-6 * (1.0 + radius + fabs(step) * cvs.length());
+
+	for (unsigned i = 0; i < cvs.length(); i++) {
+		MPoint expected(radius * cos((double) i), cvs[0].y + step * (double) i,
+			radius * sin((double) i));
+		if (cvs[i].distanceTo(expected) > tolerance)
+			return false;
+	}
+
+	desc.radius = radius;
+	desc.pitch = fabs(step);
+	desc.numCV = cvs.length();
+	desc.upDown = step < 0.0;
+	return true;
+}
+
+MStatus helixTool::exportHelices()
+	//
+	// Description
+	//     Writes every helix curve in exportList, with its world
+	//     matrix, to a binary helix file. Curves that were not built
+	//     by this tool are skipped.
+	//
+{
+	MStatus stat;
+	helixBinaryWriter writer;
+
+	stat = writer.open(exportPath);
+	if (!stat)
+		return stat;
+
+	unsigned skipped = 0;
+	for (MItSelectionList iter(exportList); !iter.isDone(); iter.next()) {
+		MDagPath curvePath;
+		helixDesc desc;
+
+		if (!iter.getDagPath(curvePath) || !curvePath.extendToShape() ||
+			!curvePath.hasFn(MFn::kNurbsCurve) ||
+			!recoverHelix(MFnNurbsCurve(curvePath), desc)) {
+			skipped++;
+			continue;
+		}
+
+		helixFileRecord record;
+		record.radius = desc.radius;
+		record.pitch = desc.pitch;
+		record.numCV = desc.numCV;
+		record.upsideDown = desc.upDown;
+		curvePath.inclusiveMatrix().get(record.matrix);
+
+		stat = writer.write(record);
+		if (!stat) {
+			stat.perror(MString("error writing ") + exportPath);
+			writer.close();
+			return stat;
+		}
+	}
+
+	if (skipped > 0) {
+		MString msg("helixToolCmd: skipped ");
+		msg += skipped;
+		msg += " objects that are not helices";
+		displayWarning(msg);
+	}
+
+	setResult((int) writer.count());
+	return writer.close();
+}
+
+MStatus helixTool::deleteHelices()
+	//
+	// Description
+	//     Removes every helix, and joint chain, created by the last
+	//     redoIt with a single modifier, so a batch is deleted in one
+	//     pass. Nodes already gone, as when the scene is cleared, are
+	//     skipped.
+	//
+{
+	MStatus stat;
+	MDagModifier dagMod;
+
+	// History first, so that nothing is left for the curve deletion
+	// to clean up behind the modifier's back.
+	for (unsigned i = 0; i < created->historyNodes.length(); i++) {
+		if (!MObjectHandle(created->historyNodes[i]).isValid())
+			continue;
+		stat = dagMod.deleteNode( created->historyNodes[i] );
+		if (!stat)
+			return stat;
+	}
+
+	for (unsigned i = 0; i < created->transforms.length(); i++) {
+		if (!MObjectHandle(created->transforms[i]).isValid())
+			continue;
+		stat = dagMod.deleteNode( created->transforms[i] );
+		if (!stat)
+			return stat;
+	}
+
+	for (unsigned i = 0; i < created->jointRoots.length(); i++) {
+		if (!MObjectHandle(created->jointRoots[i]).isValid())
+			continue;
+		stat = dagMod.deleteNode( created->jointRoots[i] );
+		if (!stat)
+			return stat;
+	}
+
+	stat = dagMod.doIt();
+	created->historyNodes.clear();
+	created->transforms.clear();
+	created->jointRoots.clear();
+	return stat;
+}
+
+MStatus helixTool::findCloud(MObject& shape) const
+	//
+	// Description
+	//     Finds the helixCloud shape named by the cloud flag, either
+	//     the shape itself or its transform.
+	//
+{
+	MSelectionList list;
+	MDagPath path;
+
+	if (!list.add(cloudName) || !list.getDagPath(0, path)) {
+		MGlobal::displayError(MString("No such helix cloud: ") + cloudName);
+		return MS::kInvalidParameter;
+	}
+	path.extendToShape();
+
+	MFnDependencyNode nodeFn(path.node());
+	if (nodeFn.typeId() != helixCloudShape::id) {
+		MGlobal::displayError(cloudName + " is not a helixCloud shape");
+		return MS::kInvalidParameter;
+	}
+
+	shape = path.node();
+	return MS::kSuccess;
+}
+
+MStatus helixTool::addToCloud()
+	//
+	// Description
+	//     Appends every helix of the command to the cloud's data as
+	//     parameters. The data is changed in place, so a command costs
+	//     only the helices it adds, however large the cloud.
+	//
+{
+	MStatus stat;
+	MObject node;
+
+	stat = findCloud(node);
+	if (!stat)
+		return stat;
+	helixCloudShape* shape = (helixCloudShape*) MFnDependencyNode(node).userNode();
+	helixCloudData* cloud = shape->editCloudData();
+	if (cloud == NULL) {
+		MGlobal::displayError(cloudName + " has its helixData connected");
+		return MS::kFailure;
+	}
+	cloudCount = cloud->count();
+
+	stat = beginHelices();
+	if (!stat)
+		return stat;
+	beginProgress();
+
+	helixDesc desc;
+	bool done = false;
+	unsigned appended = 0;
+	while (appended < createLimit) {
+		if (appended % kProgressChunk == 0 && progressInterrupted(appended))
+			break;
+
+		stat = nextHelix(desc, done);
+		if (!stat) {
+			endProgress();
+			endHelices();
+			cloud->resize(cloudCount);
+			shape->cloudDataChanged();
+			return stat;
+		}
+		if (done)
+			break;
+		cloud->append(desc.radius, desc.pitch, desc.numCV, desc.upDown,
+			desc.hasMatrix ? desc.matrix : MMatrix::identity);
+		appended++;
+	}
+	endProgress();
+	endHelices();
+	shape->cloudDataChanged();
+
+	if (interrupted) {
+		// As in redoIt, what was added is the whole of the command.
+		if (appended == 0) {
+			displayWarning("helixToolCmd: interrupted, no helices added");
+			return MS::kFailure;
+		}
+
+		MString msg("helixToolCmd: interrupted after ");
+		msg += appended;
+		msg += " helices";
+		displayWarning(msg);
+
+		createLimit = appended;
+		if (!batch.empty())
+			batch.resize(createLimit);
+		interrupted = false;
+	}
+
+	setResult((int) appended);
+	return MS::kSuccess;
+}
 
-MStatus helixTool::redoIt()
+MStatus helixTool::truncateCloud()
 	//
 	// Description
-	//     This method creates the helix curve from the
-	//     pitch and radius values
+	//     Drops the helices added by the last redoIt, which are always
+	//     the last ones in the cloud.
 	//
 {
 	MStatus stat;
+	MObject node;
 
-	const unsigned  deg     = 3;            // Curve Degree
-	const unsigned  ncvs    = numCV;		// Number of CVs
-	const unsigned  spans   = ncvs - deg;   // Number of spans
-	const unsigned  nknots  = spans+2*deg-1;// Number of knots
-	unsigned	    i;
-	MPointArray		controlVertices;
-	MDoubleArray	knotSequences;
-
-	int upFactor;
-	if (upDown) upFactor = -1;
-	else upFactor = 1;
-
-	// Set up cvs and knots for the helix
-	//
-	for (i = 0; i < ncvs; i++)
-		controlVertices.append(MPoint(radius * cos((double) i),
-		upFactor * pitch * (double) i, 
-		radius * sin((double) i)));
-
-	for (i = 0; i < nknots; i++)
-		knotSequences.append((double) i);
-
-	// Now create the curve
-	//
-	MFnNurbsCurve curveFn;
-
-	curveFn.create(controlVertices, knotSequences, deg, 
-		MFnNurbsCurve::kOpen, false, false, 
-		MObject::kNullObj, &stat);
-
-	if (!stat) {
-		stat.perror("Error creating curve");
+	stat = findCloud(node);
+	if (!stat)
 		return stat;
+	helixCloudShape* shape = (helixCloudShape*) MFnDependencyNode(node).userNode();
+	helixCloudData* cloud = shape->editCloudData();
+	if (cloud == NULL)
+		return MS::kFailure;
+
+	if (cloudCount < cloud->count()) {
+		cloud->resize(cloudCount);
+		shape->cloudDataChanged();
 	}
-
-	stat = curveFn.getPath( path );
-
-	return stat;
+	return MS::kSuccess;
 }
 
 MStatus helixTool::undoIt()
 	//
 	// Description
-	//     Removes the helix curve from the model.
+	//     Removes the helix curves from the model.
 	//
 {
-	MStatus stat; 
-	MObject transform = path.transform();
-	stat = MGlobal::deleteNode( transform );
-	return stat;
+	if (cloudName.length() > 0)
+		return truncateCloud();
+	cancelPopulation();
+	return deleteHelices();
 }
 
 bool helixTool::isUndoable() const
 	//
 	// Description
-	//     Set this command to be undoable.
+	//     Set this command to be undoable. Exporting and arena stats
+	//     do not change the scene, so there is nothing to undo.
 	//
 {
-	return true;	
+	return exportPath.length() == 0 && !arenaStats;	
 }
 
 MStatus helixTool::finalize()
@@ -279,6 +2301,10 @@ MStatus helixTool::finalize()
 	//     Command is finished, construct a string for the command
 	//     for journaling.
 	//
+	//     The context creates one helix per command, so only its four
+	//     values are journaled. With echo off the command stays out
+	//     of the journal, but is still undoable.
+	//
 {
 	MArgList command;
 	command.addArg(commandString());
@@ -290,6 +2316,8 @@ MStatus helixTool::finalize()
 	command.addArg((int) numCV);
 	command.addArg(MString(kUpsideDownFlag));
 	command.addArg(upDown);
+
+	setHistoryOn(echo);
 	return MPxToolCommand::doFinalize( command );
 }
 
@@ -313,6 +2341,22 @@ void helixTool::setUpsideDown(bool newUpsideDown)
 	upDown = newUpsideDown;
 }
 
+void helixTool::setEcho(bool newEcho)
+{
+	echo = newEcho;
+}
+
+void helixTool::setProfile(const double (*cvs)[4])
+	//
+	// Description
+	//     CVs for the next redoIt to build its single plain helix from,
+	//     numCV of them as helixProfileCVs writes them. They are not
+	//     copied: clear them with NULL before they are freed.
+	//
+{
+	profileCVs = cvs;
+}
+
 
 /////////////////////////////////////////////////////////////
 //
@@ -329,11 +2373,76 @@ void helixTool::setUpsideDown(bool newUpsideDown)
 
 const char helpString[] = "Click and drag to draw helix";
 
+// Helices with at least this many CVs are built on a worker thread,
+// so that the viewport stays live; smaller ones are quicker to build
+// directly than to hand off.
+#define kAsyncNumCVs		50000
+
+// CVs the worker builds between checks for cancellation.
+#define kAsyncChunkCVs		65536
+
+// A helix being built in the background. The worker fills cvs and
+// then helixAsyncDone sets finished; the context polls for that on
+// idle and only then commits or frees the job.
+//
+struct helixAsyncJob
+{
+	double			radius;
+	double			pitch;
+	unsigned		numCV;
+	bool			upDown;
+	std::vector<double> cvs;		// x y z w per CV
+	volatile int	finished;		// The worker is done with the job
+	volatile int	cancelled;		// Stop at the next chunk, commit nothing
+};
+
+static MThreadRetVal buildHelixAsync(void* data)
+{
+	helixAsyncJob* job = (helixAsyncJob*) data;
+	const unsigned ncvs = job->numCV;
+	const double rise = job->upDown ? -job->pitch : job->pitch;
+
+	job->cvs.resize(4 * (size_t) ncvs);
+	double (*cvs)[4] = (double (*)[4]) &job->cvs[0];
+
+	double height = 0.0;
+	for (unsigned first = 0; first < ncvs && !job->cancelled; first += kAsyncChunkCVs) {
+		const unsigned end = (ncvs - first > kAsyncChunkCVs) ? first + kAsyncChunkCVs : ncvs;
+		helixProfileCVRange(job->radius, job->radius, rise, NULL, ncvs,
+			first, end, height, cvs);
+	}
+	return 0;
+}
+
+static void helixAsyncDone(void* data)
+{
+	MAtomic::set(&((helixAsyncJob*) data)->finished, 1);
+}
+
+static void waitForAsyncJob(helixAsyncJob* job)
+	//
+	// Description
+	//     Blocks until the worker is done with a cancelled job, which
+	//     takes at most one chunk.
+	//
+{
+	while (!job->finished) {
+#ifdef _WIN32
+		Sleep(1);
+#else
+		usleep(1000);
+#endif
+	}
+}
+
 class helixContext : public MPxContext
 {
 public:
 	helixContext();
+	virtual			~helixContext();
 	virtual void	toolOnSetup(MEvent &event);
+	virtual void	toolOffCleanup();
+	virtual void	abortAction();
 	virtual MStatus doPress(MEvent &event);
 	virtual MStatus doDrag(MEvent &event);
 	virtual MStatus doRelease(MEvent &event);
@@ -344,16 +2453,25 @@ public:
 	virtual MStatus doRelease(MEvent & event, MHWRender::MUIDrawManager& drawMgr, const MHWRender::MFrameContext& context);
 	virtual MStatus doDrag(MEvent & event, MHWRender::MUIDrawManager& drawMgr, const MHWRender::MFrameContext& context);	
 	virtual MStatus doEnterRegion(MEvent & event, MHWRender::MUIDrawManager& drawMgr, const MHWRender::MFrameContext& context);
+	virtual MStatus drawFeedback(MHWRender::MUIDrawManager& drawMgr, const MHWRender::MFrameContext& context);
 
 	virtual	void	getClassName(MString & name) const;
 
 	void			setNumCVs(unsigned newNumCVs);
 	void			setUpsideDown(bool newUpsideDown);
+	void			setEcho(bool newEcho);
 	unsigned		numCVs();
 	bool			upsideDown();
+	bool			echo();
 
 private:
 	void			drawGuide();
+	void			createHelix();
+	void			startAsync();
+	static void		asyncIdle(void* clientData);
+	void			commitAsync();
+	void			cancelAsync(bool eraseGuide);
+	void			eraseAsyncGuide();
 
 	//Viewport 2 implementation
 	void            drawGuide(MEvent & event, MHWRender::MUIDrawManager& drawMgr, const MHWRender::MFrameContext& context);
@@ -363,8 +2481,13 @@ private:
 	short			endPos_x, endPos_y;
 	unsigned		numCV;
 	bool			upDown;
+	bool			echoCmd;
 	M3dView			view;
 	GLdouble		height,radius;
+	bool			pressIgnored;	// The press came while asyncJob ran
+	helixAsyncJob*	asyncJob;		// Helix being built in the background
+	MCallbackId		asyncCallback;	// Idle callback polling asyncJob
+	bool			asyncGuide;		// Legacy guide left drawn for asyncJob
 
 };
 
@@ -372,6 +2495,11 @@ helixContext::helixContext()
 {
 	numCV = 20;
 	upDown = false;
+	echoCmd = true;
+	pressIgnored = false;
+	asyncJob = NULL;
+	asyncCallback = 0;
+	asyncGuide = false;
 	setTitleString("Helix Tool");
 
 	setCursor( MCursor::defaultCursor );
@@ -381,13 +2509,174 @@ helixContext::helixContext()
 	setImage("helixTool.xpm", MPxContext::kImage1 );
 }
 
+helixContext::~helixContext()
+	//
+	// Description
+	//     The idle callback holds a pointer to the context, so a helix
+	//     still building is dropped and the callback removed with it.
+	//
+{
+	cancelAsync(false);
+}
+
 void helixContext::toolOnSetup(MEvent &)
 {
 	setHelpString(helpString);
 }
 
+void helixContext::toolOffCleanup()
+{
+	cancelAsync(true);
+	MPxContext::toolOffCleanup();
+}
+
+void helixContext::abortAction()
+	//
+	// Description
+	//     Esc cancels a helix building in the background. The worker
+	//     stops at its next chunk and the idle callback then cleans up.
+	//
+{
+	if (asyncJob && !asyncJob->cancelled) {
+		MAtomic::set(&asyncJob->cancelled, 1);
+		MGlobal::displayInfo("Helix cancelled");
+	}
+	MPxContext::abortAction();
+}
+
+void helixContext::createHelix()
+	//
+	// Description
+	//     Creates the helix described by the last drag. Helices of
+	//     kAsyncNumCVs CVs or more are built on a worker thread and
+	//     committed from idle; smaller ones are created at once.
+	//
+{
+	if (numCV >= kAsyncNumCVs) {
+		startAsync();
+		return;
+	}
+
+	helixTool * cmd = (helixTool*)newToolCommand();
+	cmd->setPitch( height/numCV );
+	cmd->setRadius( radius );
+	cmd->setNumCVs( numCV );
+	cmd->setUpsideDown( upDown );
+	cmd->setEcho( echoCmd );
+	cmd->redoIt();
+	cmd->finalize();
+}
+
+void helixContext::startAsync()
+{
+	helixAsyncJob* job = new helixAsyncJob;
+	job->radius = radius;
+	job->pitch = height / numCV;
+	job->numCV = numCV;
+	job->upDown = upDown;
+	job->finished = 0;
+	job->cancelled = 0;
+
+	MStatus stat;
+	asyncCallback = MEventMessage::addEventCallback("idle", asyncIdle, this, &stat);
+	if (stat)
+		stat = MThreadAsync::createTask(buildHelixAsync, job, helixAsyncDone, job);
+	if (!stat) {
+		if (asyncCallback)
+			MMessage::removeCallback(asyncCallback);
+		asyncCallback = 0;
+		delete job;
+		eraseAsyncGuide();
+		MGlobal::displayError("Could not start building the helix");
+		return;
+	}
+
+	asyncJob = job;
+	MGlobal::displayInfo("Building helix, press Esc to cancel");
+}
+
+void helixContext::asyncIdle(void* clientData)
+{
+	((helixContext*) clientData)->commitAsync();
+}
+
+void helixContext::commitAsync()
+	//
+	// Description
+	//     Runs on the main thread. Once the worker has finished, the
+	//     curve is created through a tool command from the CVs it
+	//     built, so it is journaled and undoable like any other.
+	//
+{
+	if (asyncJob == NULL || !asyncJob->finished)
+		return;
+
+	MMessage::removeCallback(asyncCallback);
+	asyncCallback = 0;
+
+	helixAsyncJob* job = asyncJob;
+	asyncJob = NULL;
+	eraseAsyncGuide();
+
+	if (!job->cancelled) {
+		helixTool * cmd = (helixTool*)newToolCommand();
+		cmd->setPitch( job->pitch );
+		cmd->setRadius( job->radius );
+		cmd->setNumCVs( job->numCV );
+		cmd->setUpsideDown( job->upDown );
+		cmd->setEcho( echoCmd );
+		cmd->setProfile( (const double (*)[4]) &job->cvs[0] );
+		cmd->redoIt();
+		cmd->setProfile( NULL );
+		cmd->finalize();
+	}
+
+	delete job;
+	view.refresh();
+}
+
+void helixContext::cancelAsync(bool eraseGuide)
+	//
+	// Description
+	//     Drops a helix still building when the tool is put down or
+	//     the context deleted: waits for the worker to let go of the
+	//     job, then frees it and removes the idle callback.
+	//
+{
+	if (asyncJob == NULL)
+		return;
+
+	MAtomic::set(&asyncJob->cancelled, 1);
+	waitForAsyncJob(asyncJob);
+
+	MMessage::removeCallback(asyncCallback);
+	asyncCallback = 0;
+	delete asyncJob;
+	asyncJob = NULL;
+
+	if (eraseGuide)
+		eraseAsyncGuide();
+	asyncGuide = false;
+}
+
+void helixContext::eraseAsyncGuide()
+{
+	if (asyncGuide) {
+		view.beginXorDrawing(false);
+		drawGuide();
+		view.endXorDrawing();
+		asyncGuide = false;
+	}
+}
+
 MStatus helixContext::doPress(MEvent &event)
 {
+	pressIgnored = (asyncJob != NULL);
+	if (pressIgnored) {
+		MGlobal::displayWarning("Still building the last helix, press Esc to cancel");
+		return MS::kFailure;
+	}
+
 	event.getPosition(startPos_x, startPos_y);
 	view = M3dView::active3dView();
 	firstDraw = true;
@@ -417,6 +2706,9 @@ void helixContext::drawGuide()
 
 MStatus helixContext::doDrag(MEvent & event)
 {
+	if (pressIgnored)
+		return MS::kFailure;
+
 	view.beginXorDrawing(false);
 
 	if (!firstDraw) {
@@ -438,20 +2730,23 @@ MStatus helixContext::doDrag(MEvent & event)
 
 MStatus helixContext::doRelease( MEvent & )
 {
-	//	Clear the guide from its last position.
+	if (pressIgnored)
+		return MS::kFailure;
+
+	//	Clear the guide from its last position, or leave it up
+	//	while a large helix builds.
 	if (!firstDraw) {
-		view.beginXorDrawing(false);
-		drawGuide();
-		view.endXorDrawing();
+		if (numCV < kAsyncNumCVs) {
+			view.beginXorDrawing(false);
+			drawGuide();
+			view.endXorDrawing();
+		}
+		else {
+			asyncGuide = true;
+		}
 	}
 
-	helixTool * cmd = (helixTool*)newToolCommand();
-	cmd->setPitch( height/numCV );
-	cmd->setRadius( radius );
-	cmd->setNumCVs( numCV );
-	cmd->setUpsideDown( upDown );
-	cmd->redoIt();
-	cmd->finalize();
+	createHelix();
 	return MS::kSuccess;
 }
 
@@ -464,6 +2759,12 @@ MStatus helixContext::doEnterRegion(MEvent &)
 /*Viewport 2 implementation */
 MStatus helixContext::doPress(MEvent & event, MHWRender::MUIDrawManager& drawMgr, const MHWRender::MFrameContext& context)
 {
+	pressIgnored = (asyncJob != NULL);
+	if (pressIgnored) {
+		MGlobal::displayWarning("Still building the last helix, press Esc to cancel");
+		return MS::kFailure;
+	}
+
 	event.getPosition(startPos_x, startPos_y);
 	view = M3dView::active3dView();
 	firstDraw = true;
@@ -538,6 +2839,8 @@ void helixContext::drawGuide(MEvent & event, MHWRender::MUIDrawManager& drawMgr,
 
 MStatus helixContext::doDrag(MEvent & event, MHWRender::MUIDrawManager& drawMgr, const MHWRender::MFrameContext& context)
 {
+	if (pressIgnored)
+		return MS::kFailure;
 
 
 	if (!firstDraw) {
@@ -558,18 +2861,15 @@ MStatus helixContext::doDrag(MEvent & event, MHWRender::MUIDrawManager& drawMgr,
 
 MStatus helixContext::doRelease(MEvent & event, MHWRender::MUIDrawManager& drawMgr, const MHWRender::MFrameContext& context)
 {
+	if (pressIgnored)
+		return MS::kFailure;
+
 	//	Clear the guide from its last position.
 	if (!firstDraw) {
 		drawGuide(event, drawMgr, context);
 	}
 
-	helixTool * cmd = (helixTool*)newToolCommand();
-	cmd->setPitch(height / numCV);
-	cmd->setRadius(radius);
-	cmd->setNumCVs(numCV);
-	cmd->setUpsideDown(upDown);
-	cmd->redoIt();
-	cmd->finalize();
+	createHelix();
 	return MS::kSuccess;
 }
 
@@ -578,6 +2878,17 @@ MStatus helixContext::doEnterRegion(MEvent & event, MHWRender::MUIDrawManager& d
 	return setHelpString( helpString );
 }
 
+MStatus helixContext::drawFeedback(MHWRender::MUIDrawManager& drawMgr, const MHWRender::MFrameContext& context)
+	//
+	// Description
+	//     Keeps the guide up while a large helix builds.
+	//
+{
+	if (asyncJob)
+		drawCylinder( drawMgr, radius, radius, height, upDown ? -1 : 1 );
+	return MS::kSuccess;
+}
+
 void helixContext::getClassName( MString & name ) const
 {
 	name.set("helix");
@@ -595,6 +2906,12 @@ void helixContext::setUpsideDown( bool newUpsideDown )
 	MToolsInfo::setDirtyFlag(*this);
 }
 
+void helixContext::setEcho( bool newEcho )
+{
+	echoCmd = newEcho;
+	MToolsInfo::setDirtyFlag(*this);
+}
+
 unsigned helixContext::numCVs()
 {
 	return numCV;
@@ -605,6 +2922,11 @@ bool helixContext::upsideDown()
 	return upDown;
 }
 
+bool helixContext::echo()
+{
+	return echoCmd;
+}
+
 /////////////////////////////////////////////////////////////
 //
 // Context creation command
@@ -679,6 +3001,16 @@ MStatus helixContextCmd::doEditFlags()
 		fHelixContext->setUpsideDown(upsideDown);
 	}
 
+	if (argData.isFlagSet(kEchoFlag)) {
+		bool echo;
+		status = argData.getFlagArgument(kEchoFlag, 0, echo);
+		if (!status) {
+			status.perror("echo flag parsing failed.");
+			return status;
+		}
+		fHelixContext->setEcho(echo);
+	}
+
 	return MS::kSuccess;
 }
 
@@ -692,6 +3024,9 @@ MStatus helixContextCmd::doQueryFlags()
 	if (argData.isFlagSet(kUpsideDownFlag)) {
 		setResult(fHelixContext->upsideDown());
 	}
+	if (argData.isFlagSet(kEchoFlag)) {
+		setResult(fHelixContext->echo());
+	}
 
 	return MS::kSuccess;
 }
@@ -709,6 +3044,11 @@ MStatus helixContextCmd::appendSyntax()
 		MSyntax::kBoolean)) {
 			return MS::kFailure;
 	}
+	if (MS::kSuccess != 
+		mySyntax.addFlag(kEchoFlag, kEchoFlagLong,
+		MSyntax::kBoolean)) {
+			return MS::kFailure;
+	}
 
 	return MS::kSuccess;
 }
@@ -724,6 +3064,90 @@ MStatus initializePlugin( MObject obj )
 	MStatus status;
 	MFnPlugin plugin(obj, PLUGIN_COMPANY, "3.0", "Any");
 
+	// Large springs are built on Maya's thread pool.
+	//
+	status = MThreadPool::init();
+	if (!status) {
+		status.perror("MThreadPool::init");
+		return status;
+	}
+
+	// The tool context builds large helices with MThreadAsync.
+	//
+	status = MThreadAsync::init();
+	if (!status) {
+		status.perror("MThreadAsync::init");
+		return status;
+	}
+
+	status = plugin.registerData(helixCloudData::typeName,
+		helixCloudData::id, helixCloudData::creator);
+	if (!status) {
+		status.perror("registerData");
+		return status;
+	}
+
+	status = plugin.registerShape(helixCloudShape::typeName,
+		helixCloudShape::id, helixCloudShape::creator,
+		helixCloudShape::initialize, helixCloudShapeUI::creator,
+		&helixCloudGeometryOverride::drawDbClassification);
+	if (!status) {
+		status.perror("registerShape");
+		return status;
+	}
+
+	status = plugin.registerNode(helixNode::typeName, helixNode::id,
+		helixNode::creator, helixNode::initialize);
+	if (!status) {
+		status.perror("registerNode helixNode");
+		return status;
+	}
+
+	status = plugin.registerNode(helixInstancer::typeName, helixInstancer::id,
+		helixInstancer::creator, helixInstancer::initialize);
+	if (!status) {
+		status.perror("registerNode helixInstancer");
+		return status;
+	}
+
+	status = plugin.registerNode(helixSpringSim::typeName, helixSpringSim::id,
+		helixSpringSim::creator, helixSpringSim::initialize);
+	if (!status) {
+		status.perror("registerNode helixSpringSim");
+		return status;
+	}
+
+	status = plugin.registerNode(helixCompress::typeName, helixCompress::id,
+		helixCompress::creator, helixCompress::initialize,
+		MPxNode::kDeformerNode);
+	if (!status) {
+		status.perror("registerNode helixCompress");
+		return status;
+	}
+
+	status = MHWRender::MDrawRegistry::registerGeometryOverrideCreator(
+		helixCloudGeometryOverride::drawDbClassification,
+		helixCloudGeometryOverride::registrantId,
+		helixCloudGeometryOverride::Creator);
+	if (!status) {
+		status.perror("registerGeometryOverrideCreator");
+		return status;
+	}
+
+	status = plugin.registerCommand(helixFitCmd::commandName,
+		helixFitCmd::creator, helixFitCmd::newSyntax);
+	if (!status) {
+		status.perror("registerCommand helixFit");
+		return status;
+	}
+
+	status = plugin.registerCommand(helixQueryCmd::commandName,
+		helixQueryCmd::creator, helixQueryCmd::newSyntax);
+	if (!status) {
+		status.perror("registerCommand helixQuery");
+		return status;
+	}
+
 	// Register the context creation command and the tool command 
 	// that the helixContext will use.
 	// 
@@ -754,5 +3178,68 @@ MStatus uninitializePlugin( MObject obj)
 		return status;
 	}
 
+	status = plugin.deregisterCommand(helixQueryCmd::commandName);
+	if (!status) {
+		status.perror("deregisterCommand helixQuery");
+		return status;
+	}
+
+	status = plugin.deregisterCommand(helixFitCmd::commandName);
+	if (!status) {
+		status.perror("deregisterCommand helixFit");
+		return status;
+	}
+
+	status = MHWRender::MDrawRegistry::deregisterGeometryOverrideCreator(
+		helixCloudGeometryOverride::drawDbClassification,
+		helixCloudGeometryOverride::registrantId);
+	if (!status) {
+		status.perror("deregisterGeometryOverrideCreator");
+		return status;
+	}
+
+	status = plugin.deregisterNode(helixCompress::id);
+	if (!status) {
+		status.perror("deregisterNode helixCompress");
+		return status;
+	}
+
+	status = plugin.deregisterNode(helixSpringSim::id);
+	if (!status) {
+		status.perror("deregisterNode helixSpringSim");
+		return status;
+	}
+
+	status = plugin.deregisterNode(helixInstancer::id);
+	if (!status) {
+		status.perror("deregisterNode helixInstancer");
+		return status;
+	}
+
+	status = plugin.deregisterNode(helixNode::id);
+	if (!status) {
+		status.perror("deregisterNode helixNode");
+		return status;
+	}
+
+	status = plugin.deregisterNode(helixCloudShape::id);
+	if (!status) {
+		status.perror("deregisterNode");
+		return status;
+	}
+
+	status = plugin.deregisterData(helixCloudData::id);
+	if (!status) {
+		status.perror("deregisterData");
+		return status;
+	}
+
+	helixTool::clearPopulateQueue();
+	helixClearSpringTopologies();
+	helixGetArena().release();
+	clearPathCache();
+	MThreadAsync::release();
+	MThreadPool::release();
+
 	return status;
 }